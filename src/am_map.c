@@ -509,7 +509,7 @@ void AM_unloadPics(void)
     int i;
   
     for (i=0;i<10;i++)
-	Z_ChangeTag(marknums[i], PU_CACHE);
+	W_ReleaseLump(marknums[i]);
 
 }
 
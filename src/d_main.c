@@ -52,6 +52,7 @@
 #include "m_argv.h"
 #include "m_misc.h"
 #include "m_menu.h"
+#include "m_prof.h"
 
 #include "i_system.h"
 #include "i_video.h"
@@ -318,10 +319,14 @@ void D_Display (void)
 
 	// normal update
 	if (!wipe) {
+		M_ProfBegin (prof_present);
 		I_FinishUpdate ();              // page flip or blit buffer
+		M_ProfEnd (prof_present);
 		return;
 	}
 
+	M_ProfBegin (prof_wipe);
+
 	// wipe update
 	wipe_EndScreen(0, 0, sysvideo.width, sysvideo.height);
 
@@ -338,6 +343,7 @@ void D_Display (void)
 		M_Drawer ();					// menu is drawn even on top of wipes
 		I_FinishUpdate ();				// page flip or blit buffer
 	} while (!done);
+	M_ProfEnd (prof_wipe);
 }
 
 
@@ -370,20 +376,28 @@ void D_DoomLoop (void)
 			if (advancedemo)
 				D_DoAdvanceDemo ();
 			M_Ticker ();
+			M_ProfBegin (prof_ticker);
 			G_Ticker ();
+			M_ProfEnd (prof_ticker);
 			gametic++;
 			maketic++;
 		} else {
 			TryRunTics (); // will run at least one tic
 		}
 
+		M_ProfBegin (prof_sound);
 		S_UpdateSounds (players[consoleplayer].mo);// move positional sounds
+		M_ProfEnd (prof_sound);
 
 		// Update display, next frame, with current state.
 		D_Display ();
 
+		M_ProfBegin (prof_sound);
         // temp
         I_UpdateMusic(0, 0, 0);
+		M_ProfEnd (prof_sound);
+
+		M_ProfFrame ();
 	}
 }
 
@@ -841,6 +855,26 @@ void D_DoomMain (void)
     if (p) {
 		sysvideo.overlay = sysvideo.resize = true;
 	}
+	p=M_CheckParm ("-pipeline");
+    if (p) {
+		sysvideo.pipeline = true;
+	}
+	p=M_CheckParm ("-quadcols");
+    if (p) {
+		sysvideo.quad_columns = true;
+	}
+	p=M_CheckParm ("-pvs");
+    if (p) {
+		sysvideo.pvs = true;
+	}
+	p=M_CheckParm ("-benchconv");
+    if (p) {
+		sysvideo.bench_convert = true;
+	}
+	p=M_CheckParm ("-rthreads");
+    if (p && (p<myargc-1)) {
+		sysvideo.render_threads = atoi(myargv[p+1]);
+	}
 
 	p=M_CheckParm ("-network");
     if (p && (p<myargc-1)) {
@@ -865,6 +899,22 @@ void D_DoomMain (void)
 		}
 	}
 
+	p=M_CheckParm ("-benchmix");
+	if (p) {
+		sysaudio.bench_mix = true;
+	}
+
+	sysaudio.kb_sfx = DEFAULT_SFX_CACHE_SIZE;
+	p=M_CheckParm ("-sfxcache");
+    if (p && (p<myargc-1)) {
+		sysaudio.kb_sfx = atoi(myargv[p+1]);
+	}
+
+	p=M_CheckParm ("-oplfast");
+	if (p) {
+		sysaudio.opl_fast = true;
+	}
+
 	p=M_CheckParm ("-audio");
     if (p && (p<myargc-1)) {
 		if (strcmp(myargv[p+1],"off")==0) {
@@ -880,6 +930,26 @@ void D_DoomMain (void)
 			sysgame.kb_used=MINIMAL_HEAP_SIZE;
 	}
 
+	p=M_CheckParm ("-compcache");
+    if (p && (p<myargc-1)) {
+		sysgame.kb_composites = atoi(myargv[p+1]);
+	}
+
+	p=M_CheckParm ("-mmap");
+	if (p) {
+		sysgame.mmap_wads = true;
+	}
+
+	p=M_CheckParm ("-nodatacache");
+	if (p) {
+		sysgame.data_cache = false;
+	}
+
+	p=M_CheckParm ("-profile");
+	if (p && (p<myargc-1)) {
+		M_ProfInit (myargv[p+1]);
+	}
+
 	p=M_CheckParm ("-cdmusic");
 	if (p && (gamemode!=commercial)) {
 		i_CDMusic = true;
@@ -1215,6 +1285,9 @@ void D_DoomMain (void)
 	if ( ( gamemode == commercial ) && (W_CheckNumForName("map01")<0) )
 		store_demo = true;
 
+    if (devparm)
+	W_PrintLookupStats ();
+
     // check for a driver that wants intermission stats
     p = M_CheckParm ("-statcopy");
     if (p && p<myargc-1)
@@ -1246,6 +1319,7 @@ void D_DoomMain (void)
     p = M_CheckParm ("-timedemo");
     if (p && p < myargc-1)
     {
+	M_ProfInit (NULL);
 	G_TimeDemo (myargv[p+1]);
 	D_DoomLoop ();  // never returns
     }
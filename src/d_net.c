@@ -23,6 +23,7 @@
 #include <string.h>
 
 #include "m_menu.h"
+#include "m_prof.h"
 #include "i_system.h"
 #include "i_video.h"
 #include "i_net.h"
@@ -690,7 +691,9 @@ void TryRunTics (void)
 			if (advancedemo)
 				D_DoAdvanceDemo ();
 			M_Ticker ();
+			M_ProfBegin (prof_ticker);
 			G_Ticker ();
+			M_ProfEnd (prof_ticker);
 			gametic++;
 
 			// modify command for duplicated tics
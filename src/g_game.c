@@ -29,6 +29,7 @@
 #include "m_misc.h"
 #include "m_menu.h"
 #include "m_random.h"
+#include "m_prof.h"
 #include "i_system.h"
 
 #include "p_setup.h"
@@ -1655,6 +1656,7 @@ boolean G_CheckDemoStatus (void)
     if (timingdemo) 
     { 
 	endtime = I_GetTime (); 
+	M_ProfReport ();
 	I_Error ("timed %i gametics in %i realtics",gametic 
 		 , endtime-starttime); 
     } 
@@ -1664,7 +1666,7 @@ boolean G_CheckDemoStatus (void)
 	if (singledemo) 
 	    I_Quit (); 
 			 
-	Z_ChangeTag (demobuffer, PU_CACHE); 
+	W_ReleaseLump (demobuffer); 
 	demoplayback = false; 
 	netdemo = false;
 	netgame = false;
@@ -30,6 +30,11 @@ typedef struct {
 
     boolean sdl_available;
 	boolean convert;
+	boolean bench_mix;
+	int	kb_sfx;		/* Resampled sound effects kept, in KB */
+	boolean	opl_fast;	/* Cheaper software OPL */
+	/* Music rendered by the sound mixer, added to its 32 bits stereo buffer */
+	void	(*mix_music)(Sint32 *mix, int count);
 	SDL_AudioSpec	desired;
 	SDL_AudioSpec	obtained;
 	SDL_AudioCVT	audioCvt;
@@ -37,8 +42,10 @@ typedef struct {
 
 extern sysaudio_t sysaudio;
 
-#define NUM_CHANNELS		4
+/* Most sound effects mixed at once, snd_channels sets how many */
+#define NUM_CHANNELS		32
 #define SAMPLERATE		    11025
 #define SAMPLECOUNT		    512
+#define DEFAULT_SFX_CACHE_SIZE	2048	/* in KB */
 
 #endif
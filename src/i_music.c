@@ -21,6 +21,7 @@
 #include "config.h"
 #endif
 
+#include <string.h>
 #include <SDL.h>
 
 #include "doomdef.h"
@@ -36,6 +37,8 @@
 #include "i_music_midi.h"
 #include "sounds.h"
 #include "w_wad.h"
+#include "mus2mid.h"
+#include "memio.h"
 
 typedef struct 
 {
@@ -198,6 +201,73 @@ void I_UnRegisterSong(int handle)
     }
 }
 
+//
+// Songs converted to MIDI, by lump number. The zone purges them
+//  like cached lumps while they are not played.
+//
+static void**	songcache;
+static int*	songlength;
+
+void *I_CacheSong(int lump, int tag, int *length)
+{
+    void*	data;
+    void*	outbuf;
+    size_t	outbuf_len;
+    MEMFILE*	instream;
+    MEMFILE*	outstream;
+
+    if (!songcache) {
+        songcache = Z_Malloc(numlumps * sizeof(*songcache), PU_STATIC, NULL);
+        songlength = Z_Malloc(numlumps * sizeof(*songlength), PU_STATIC, NULL);
+        memset(songcache, 0, numlumps * sizeof(*songcache));
+        memset(songlength, 0, numlumps * sizeof(*songlength));
+    }
+
+    if (songcache[lump]) {
+        Z_ChangeTag(songcache[lump], tag);
+        *length = songlength[lump];
+        return songcache[lump];
+    }
+
+    *length = W_LumpLength(lump);
+    data = W_CacheLumpNum(lump, tag);
+
+    // MIDI lumps are played as they are
+    if ((*length > 4) && !memcmp(data, "MThd", 4)) {
+        return data;
+    }
+
+    instream = mem_fopen_read(data, *length);
+    outstream = mem_fopen_write();
+    if (mus2mid(instream, outstream) == 0) {
+        mem_get_buf(outstream, &outbuf, &outbuf_len);
+        Z_Malloc(outbuf_len, tag, &songcache[lump]);
+        memcpy(songcache[lump], outbuf, outbuf_len);
+        songlength[lump] = outbuf_len;
+    }
+    mem_fclose(instream);
+    mem_fclose(outstream);
+
+    // Neither MUS nor MIDI, the driver sees the lump
+    if (!songcache[lump]) {
+        return data;
+    }
+
+    W_ReleaseLumpNum(lump);
+    *length = songlength[lump];
+    return songcache[lump];
+}
+
+// Makes the song of I_CacheSong purgable again.
+void I_ReleaseSong(int lump)
+{
+    if (songcache && songcache[lump]) {
+        Z_ChangeTag(songcache[lump], PU_CACHE);
+    } else {
+        W_ReleaseLumpNum(lump);
+    }
+}
+
 int I_RegisterSong(void* data, int length)
 {
     if (sysaudio.music_enabled) {
@@ -33,6 +33,10 @@ void I_SetMusicVolume(int volume);
 // PAUSE game handling.
 void I_PauseSong(int handle);
 void I_ResumeSong(int handle);
+// Song of a lump as MIDI data, MUS is converted once and kept
+//  in the zone like a cached lump. Release it with I_ReleaseSong.
+void *I_CacheSong(int lump, int tag, int *length);
+void I_ReleaseSong(int lump);
 // Registers a song handle to song data.
 int I_RegisterSong(void *data, int length);
 // Called by anything that wishes to start music.
@@ -21,7 +21,9 @@
 #include "config.h"
 #endif
 
+#ifdef __MINT__
 #include <mint/osbind.h>
+#endif
 #include <SDL.h>
 
 #include "z_zone.h"
@@ -30,10 +32,6 @@
 #include "i_music.h"
 #include "i_music_midi.h"
 #include "md_midi.h"
-#include "mus2mid.h"
-#include "memio.h"
-
-#define MAXMIDLENGTH (96 * 1024)
 
 static int current_music_volume;
 
@@ -43,7 +41,7 @@ static boolean song_paused = 0;
 static boolean song_playing = 0;
 static unsigned int currentmicros = 0;
 static MD_MIDIFile* midi = 0;
-static void* midibuf = 0;
+static boolean timer_installed = false;
 
 // --------------------------------------------------------------------------------
 static int32_t (*biosMidiOut)(uint32_t data) = 0;
@@ -78,7 +76,7 @@ static void midiMetaHandler(const MD_meta_event* event) {
 
 
 // --------------------------------------------------------------------------------
-static void PeriodicUpdate(unsigned int elapsed) {
+void I_AdvanceSong_MIDI(unsigned int elapsed) {
     if (midi && song_playing && !song_paused) {
         currentmicros += elapsed;
         MD_Update(midi, currentmicros);
@@ -92,6 +90,7 @@ static void PeriodicUpdate(unsigned int elapsed) {
     }
 }
 
+#ifdef __MINT__
 static void TimerCallback() {
 
     static uint32_t last200hz = 0;
@@ -103,7 +102,7 @@ static void TimerCallback() {
         // 5ms per 200hz tick
         microseconds = (this200hz - last200hz) * 5000UL;
     }
-    PeriodicUpdate(microseconds);
+    I_AdvanceSong_MIDI(microseconds);
     last200hz = this200hz;
 }
 
@@ -154,17 +153,32 @@ static void UninstallTimer() {
     }
     RestoreInterrupts(sr);
 }
+#endif
 
 // --------------------------------------------------------------------------------
 
 int I_InitMusic_MIDI(void) { 
+#ifdef __MINT__
     Supexec(InstallTimer);
+    timer_installed = true;
+#endif
     return true;    
 }
 
+// The caller advances the song itself, see I_AdvanceSong_MIDI.
+int I_InitMusicUntimed_MIDI(void) {
+    timer_installed = false;
+    return true;
+}
+
 void I_ShutdownMusic_MIDI(void) {
     I_StopSong_MIDI(0);
-    Supexec(UninstallTimer);
+#ifdef __MINT__
+    if (timer_installed) {
+        Supexec(UninstallTimer);
+        timer_installed = false;
+    }
+#endif
 }
 
 void I_PlaySong_MIDI(int handle, int looping) {
@@ -212,33 +226,10 @@ int I_RegisterSong_MIDI(void* data, int len) {
         midi = NULL;
     }
 
-    if ((len > 4) && (len < MAXMIDLENGTH) && !memcmp(data, "MThd", 4)) {
-        /* midi data */
-        midibuf = Z_Malloc(len, PU_STATIC, data);
-        if (midibuf) {
-            memcpy(midibuf, data, len);
-            midi = MD_OpenBuffer(midibuf);
-        }
-    } else {
-        /* mus data */
-        MEMFILE *instream = mem_fopen_read(data, len);
-        MEMFILE* outstream = mem_fopen_write();
-        if (instream && outstream) {
-            if (mus2mid(instream, outstream) == 0)
-            {
-                void *outbuf; size_t outbuf_len;
-                mem_get_buf(outstream, &outbuf, &outbuf_len);
-                if (outbuf_len > 4) {
-                    midibuf = Z_Malloc(outbuf_len, PU_STATIC, data);
-                    if (midibuf) {
-                        memcpy(midibuf, outbuf, outbuf_len);
-                        midi = MD_OpenBuffer(midibuf);
-                    }
-                }
-            }
-            mem_fclose(instream);
-            mem_fclose(outstream);
-        }
+    /* MUS was converted by I_CacheSong, the caller keeps the
+       data until the song is unregistered */
+    if ((len > 4) && !memcmp(data, "MThd", 4)) {
+        midi = MD_OpenBuffer(data);
     }
 
     if (midi) {
@@ -256,10 +247,6 @@ void I_UnRegisterSong_MIDI(int handle) {
         song_playing = false;
         MD_Close(midi);
         midi = NULL;
-        if (midibuf) {
-            Z_Free(midibuf);
-            midibuf = 0;
-        }
     }
 }
 
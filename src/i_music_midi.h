@@ -22,6 +22,8 @@
 
 void I_UpdateMusic_MIDI(void *unused, Uint8 *stream, int len);
 int  I_InitMusic_MIDI(void);
+int  I_InitMusicUntimed_MIDI(void);
+void I_AdvanceSong_MIDI(unsigned int elapsed);
 void I_ShutdownMusic_MIDI(void);
 void I_SetMusicVolume_MIDI(int volume);
 void I_PauseSong_MIDI(int handle);
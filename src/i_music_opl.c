@@ -44,11 +44,17 @@
 #include "mus2mid.h"
 #include "memio.h"
 #include "opl.h"
+#include "opl_sw.h"
 
+#ifdef __MINT__
 #include <mint/osbind.h>
+#endif
 
 #define MAXMIDLENGTH (96 * 1024)
 
+// Song position update of the emulated chip, in microseconds
+#define OPL_SW_TICK 1000
+
 #define MIDI_CHANNELS_PER_TRACK 16
 
 #define MIDI_RPN_MSB                 0x00
@@ -355,6 +361,7 @@ static unsigned int last_perc_count;
 // Configuration file variable, containing the port number for the adlib chip.
 static int opl_io_port = 0x388;
 static boolean opl_stereo_correct = false;
+static boolean opl_software = false;
 static int start_music_volume;
 static int current_music_volume;
 
@@ -1086,10 +1093,23 @@ static void InitChannel(opl_channel_data_t *channel)
 
 // --------------------------------------------------------------------------------
 
+// The emulated chip advances the song from the audio callback,
+// between the samples it renders.
+static void SongTick(void *unused) {
+    I_AdvanceSong_MIDI(OPL_SW_TICK);
+    OPL_SetCallback(OPL_SW_TICK, SongTick, NULL);
+}
+
 int I_InitMusic_OPL(void)
 { 
     opl_init_result_t chip_type;
+    opl_software = false;
     chip_type = OPL_Init(opl_io_port);
+    if ((chip_type == OPL_INIT_NONE) && sysaudio.sdl_available) {
+        printf("I_InitMusic_OPL: No Adlib, emulating an OPL3\n");
+        chip_type = OPL_InitSoftware(sysaudio.obtained.freq, sysaudio.opl_fast);
+        opl_software = true;
+    }
     if (chip_type == OPL_INIT_NONE) {
         printf("Dude.  The Adlib isn't responding.\n");
         return false;
@@ -1113,7 +1133,16 @@ int I_InitMusic_OPL(void)
 
     InitVoices();
 
-    if (!I_InitMusic_MIDI()) {
+    if (opl_software) {
+        if (!I_InitMusicUntimed_MIDI()) {
+            OPL_Shutdown();
+            return false;
+        }
+        OPL_Lock();
+        OPL_SetCallback(OPL_SW_TICK, SongTick, NULL);
+        sysaudio.mix_music = OPL_SW_Render;
+        OPL_Unlock();
+    } else if (!I_InitMusic_MIDI()) {
         OPL_Shutdown();
         return false;
     }
@@ -1122,22 +1151,35 @@ int I_InitMusic_OPL(void)
 }
 
 void I_ShutdownMusic_OPL(void) {
+    OPL_Lock();
     I_ShutdownMusic_MIDI();
+    if (opl_software) {
+        sysaudio.mix_music = NULL;
+        OPL_ClearCallbacks();
+    }
+    OPL_Unlock();
+    OPL_Shutdown();
 }
 
+// The emulated chip plays from the audio callback, the song is
+// only changed while it is locked out.
+
 void I_PlaySong_OPL(int handle, int looping) {
 
-    I_StopSong_OPL(handle);
+    OPL_Lock();
+    I_StopSong_MIDI(handle);
     for (int i = 0; i < MIDI_CHANNELS_PER_TRACK; ++i) {
         InitChannel(&channels[i]);
     }
 
     start_music_volume = current_music_volume;
     I_PlaySong_MIDI(handle, looping);
+    OPL_Unlock();
 }
 
 void I_SetMusicVolume_OPL(int volume)
 {
+    OPL_Lock();
     if (current_music_volume != volume) {
         current_music_volume = volume;
         for (unsigned int i = 0; i < MIDI_CHANNELS_PER_TRACK; ++i) {
@@ -1148,32 +1190,43 @@ void I_SetMusicVolume_OPL(int volume)
             }
         }    
     }
+    OPL_Unlock();
 }
 
 void I_PauseSong_OPL(int handle) {
+    OPL_Lock();
     I_PauseSong_MIDI(handle);
+    OPL_Unlock();
 }
 
 void I_ResumeSong_OPL(int handle) {
+    OPL_Lock();
     I_ResumeSong_MIDI(handle);
+    OPL_Unlock();
 }
 
 void I_StopSong_OPL(int handle) {
+    OPL_Lock();
     I_StopSong_MIDI(handle);
+    OPL_Unlock();
 }
 
 int I_RegisterSong_OPL(void* data, int len) {
+    OPL_Lock();
     MD_MIDIFile* midi = (MD_MIDIFile*) I_RegisterSong_MIDI(data, len);
     if (midi) {    
         midi->_midiHandler = midiEventHandler;
         midi->_sysexHandler = midiSysexHandler;
         midi->_metaHandler = midiMetaHandler;
     }
+    OPL_Unlock();
     return (int) midi;
 }
 
 void I_UnRegisterSong_OPL(int handle) {
+    OPL_Lock();
     I_UnRegisterSong_MIDI(handle);
+    OPL_Unlock();
 }
 
 int I_QrySongPlaying_OPL(int handle) {
@@ -10,6 +10,24 @@ static Uint8 p2y[256];
 static Uint8 p2u[256];
 static Uint8 p2v[256];
 
+/* Packed overlays: the first pixel of a pair gives Y, U and V, the
+   second one only adds its Y, so a pair is written as a single Uint32 */
+static Uint32 p2yuy2[256];
+static Uint32 p2uyvy[256];
+static Uint32 p2yvyu[256];
+static Uint32 p2y2[256];	/* Y as third byte */
+static Uint32 p2y3[256];	/* Y as fourth byte */
+
+/* 8bits to 32bits screen */
+static Uint32 p2rgb32[256];
+
+/* Place byte b at offset n in memory */
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+#define PACK(b,n)	((Uint32)(b)<<((n)*8))
+#else
+#define PACK(b,n)	((Uint32)(b)<<((3-(n))*8))
+#endif
+
 void I_Pal2Yuv(SDL_Color *palette)
 {
 	int i, r,g,b, y,u,v;
@@ -30,6 +48,21 @@ void I_Pal2Yuv(SDL_Color *palette)
 		p2y[i] = y;
 		p2u[i] = u;
 		p2v[i] = v;
+
+		p2yuy2[i] = PACK(y,0)|PACK(u,1)|PACK(v,3);
+		p2uyvy[i] = PACK(u,0)|PACK(y,1)|PACK(v,2);
+		p2yvyu[i] = PACK(y,0)|PACK(v,1)|PACK(u,3);
+		p2y2[i] = PACK(y,2);
+		p2y3[i] = PACK(y,3);
+	}
+}
+
+void I_Pal2Rgb32(SDL_Color *palette, SDL_PixelFormat *format)
+{
+	int i;
+
+	for (i=0; i<256; i++) {
+		p2rgb32[i] = SDL_MapRGB(format, palette[i].r, palette[i].g, palette[i].b);
 	}
 }
 
@@ -48,75 +81,46 @@ static inline void RGBtoYUV(Uint8 *rgb, int *yuv)
 
 /*--- 8bits paletted to overlay ---*/
 
-void I_RGB8toYV12(SDL_Surface *s, SDL_Overlay *o)
+/* Y plane four pixels at a time, U and V planes from the first pixel
+   of each pair, on even lines only */
+static void I_RGB8toPlanar(SDL_Surface *s, SDL_Overlay *o, int uplane, int vplane)
 {
-	int x,y;
-	Uint8 *p,*op[3];
+	int x,y,w,h;
+	Uint8 *p,*yp,*up,*vp;
+	Uint32 *yp4;
 
 	SDL_LockSurface(s);
 	SDL_LockYUVOverlay(o);
 
-	/* Black initialization */
-	/*
-	memset(o->pixels[0],0,o->pitches[0]*o->h);
-	memset(o->pixels[1],128,o->pitches[1]*((o->h+1)/2));
-	memset(o->pixels[2],128,o->pitches[2]*((o->h+1)/2));
-	*/
+	w = (s->w < o->w ? s->w : o->w);
+	h = (s->h < o->h ? s->h : o->h);
 
-	/* Convert */
-	for(y=0; y<s->h && y<o->h; y++)
+	for(y=0; y<h; y++)
 	{
 		p=((Uint8 *) s->pixels)+s->pitch*y;
-		op[0]=o->pixels[0]+o->pitches[0]*y;
-		op[1]=o->pixels[1]+o->pitches[1]*(y/2);
-		op[2]=o->pixels[2]+o->pitches[2]*(y/2);
-		for(x=0; x<s->w && x<o->w; x++)
+		yp4=(Uint32 *) (o->pixels[0]+o->pitches[0]*y);
+		for(x=0; x<(w & ~3); x+=4, p+=4)
 		{
-			int c = *p++;
-			*(op[0]++)=p2y[c];
-			if(x%2==0 && y%2==0)
-			{
-				*(op[1]++)=p2v[c];
-				*(op[2]++)=p2u[c];
-			}
+			*yp4++ = PACK(p2y[p[0]],0)|PACK(p2y[p[1]],1)
+				|PACK(p2y[p[2]],2)|PACK(p2y[p[3]],3);
+		}
+		yp=(Uint8 *) yp4;
+		for(; x<w; x++)
+		{
+			*yp++ = p2y[*p++];
 		}
-	}
-
-	SDL_UnlockYUVOverlay(o);
-	SDL_UnlockSurface(s);
-}
- 
-void I_RGB8toIYUV(SDL_Surface *s, SDL_Overlay *o)
-{
-	int x,y;
-	Uint8 *p,*op[3];
-
-	SDL_LockSurface(s);
-	SDL_LockYUVOverlay(o);
 
-	/* Black initialization */
-	/*
-	memset(o->pixels[0],0,o->pitches[0]*o->h);
-	memset(o->pixels[1],128,o->pitches[1]*((o->h+1)/2));
-	memset(o->pixels[2],128,o->pitches[2]*((o->h+1)/2));
-	*/
+		if (y & 1)
+			continue;
 
-	/* Convert */
-	for(y=0; y<s->h && y<o->h; y++)
-	{
 		p=((Uint8 *) s->pixels)+s->pitch*y;
-		op[0]=o->pixels[0]+o->pitches[0]*y;
-		op[1]=o->pixels[1]+o->pitches[1]*(y/2);
-		op[2]=o->pixels[2]+o->pitches[2]*(y/2);
-		for(x=0; x<s->w && x<o->w; x++)
+		up=o->pixels[uplane]+o->pitches[uplane]*(y>>1);
+		vp=o->pixels[vplane]+o->pitches[vplane]*(y>>1);
+		for(x=0; x<w; x+=2, p+=2)
 		{
-			int c = *p++;
-			*(op[0]++)=p2y[c];
-			if(x%2==0 && y%2==0)
-			{
-				*(op[1]++)=p2u[c];
-				*(op[2]++)=p2v[c];
-			}
+			int c = *p;
+			*up++ = p2u[c];
+			*vp++ = p2v[c];
 		}
 	}
 
@@ -124,29 +128,36 @@ void I_RGB8toIYUV(SDL_Surface *s, SDL_Overlay *o)
 	SDL_UnlockSurface(s);
 }
 
-void I_RGB8toUYVY(SDL_Surface *s, SDL_Overlay *o)
+/* One Uint32 per pair of pixels, two pairs per loop */
+static void I_RGB8toPacked(SDL_Surface *s, SDL_Overlay *o, Uint32 *even, Uint32 *odd)
 {
-	int x,y;
-	Uint8 *p,*op;
+	int x,y,w,h;
+	Uint8 *p;
+	Uint32 *op;
 
 	SDL_LockSurface(s);
 	SDL_LockYUVOverlay(o);
 
-	for(y=0; y<s->h && y<o->h; y++)
+	w = (s->w < o->w ? s->w : o->w);
+	h = (s->h < o->h ? s->h : o->h);
+
+	for(y=0; y<h; y++)
 	{
 		p=((Uint8 *) s->pixels)+s->pitch*y;
-		op=o->pixels[0]+o->pitches[0]*y;
-		for(x=0; x<s->w && x<o->w; x++)
+		op=(Uint32 *) (o->pixels[0]+o->pitches[0]*y);
+		for(x=0; x<(w & ~3); x+=4, p+=4)
 		{
-			int c = *p++;
-			if(x%2==0)
-			{
-				*(op++)=p2u[c];
-				*(op++)=p2y[c];
-				*(op++)=p2v[c];
-			}
-			else
-				*(op++)=p2y[c];
+			op[0] = even[p[0]] | odd[p[1]];
+			op[1] = even[p[2]] | odd[p[3]];
+			op+=2;
+		}
+		for(; x<(w & ~1); x+=2, p+=2)
+		{
+			*op++ = even[p[0]] | odd[p[1]];
+		}
+		if (x<w)
+		{
+			*op = even[p[0]];
 		}
 	}
 
@@ -154,69 +165,78 @@ void I_RGB8toUYVY(SDL_Surface *s, SDL_Overlay *o)
 	SDL_UnlockSurface(s);
 }
 
-void I_RGB8toYVYU(SDL_Surface *s, SDL_Overlay *o)
+void I_RGB8toYV12(SDL_Surface *s, SDL_Overlay *o)
 {
-	int x,y;
-	Uint8 *p,*op;
+	I_RGB8toPlanar(s, o, 2, 1);
+}
 
-	SDL_LockSurface(s);
-	SDL_LockYUVOverlay(o);
+void I_RGB8toIYUV(SDL_Surface *s, SDL_Overlay *o)
+{
+	I_RGB8toPlanar(s, o, 1, 2);
+}
 
-	for(y=0; y<s->h && y<o->h; y++)
-	{
-		p=((Uint8 *) s->pixels)+s->pitch*y;
-		op=o->pixels[0]+o->pitches[0]*y;
-		for(x=0; x<s->w && x<o->w; x++)
-		{
-			int c = *p++;
-			if(x%2==0)
-			{
-				*(op++)=p2y[c];
-				*(op++)=p2v[c];
-				op[1]=p2u[c];
-			}
-			else
-			{
-				*op=p2y[c];
-				op+=2;
-			}
-		}
-	}
+void I_RGB8toUYVY(SDL_Surface *s, SDL_Overlay *o)
+{
+	I_RGB8toPacked(s, o, p2uyvy, p2y3);
+}
 
-	SDL_UnlockYUVOverlay(o);
-	SDL_UnlockSurface(s);
+void I_RGB8toYVYU(SDL_Surface *s, SDL_Overlay *o)
+{
+	I_RGB8toPacked(s, o, p2yvyu, p2y2);
 }
 
 void I_RGB8toYUY2(SDL_Surface *s, SDL_Overlay *o)
 {
-	int x,y;
-	Uint8 *p,*op;
+	I_RGB8toPacked(s, o, p2yuy2, p2y2);
+}
 
-	SDL_LockSurface(s);
-	SDL_LockYUVOverlay(o);
+/*--- 8bits paletted to 32bits surface ---*/
 
-	for(y=0; y<s->h && y<o->h; y++)
+/* Converts area->w x area->h pixels from the top left of s,
+   to area->x,area->y in d. Eight pixels per loop. */
+void I_RGB8toRGB32(SDL_Surface *s, SDL_Surface *d, SDL_Rect *area)
+{
+	int x,y,w,h;
+	Uint8 *p;
+	Uint32 *op;
+
+	SDL_LockSurface(s);
+	SDL_LockSurface(d);
+
+	w = area->w;
+	if (w > s->w)
+		w = s->w;
+	if (w > d->w - area->x)
+		w = d->w - area->x;
+	h = area->h;
+	if (h > s->h)
+		h = s->h;
+	if (h > d->h - area->y)
+		h = d->h - area->y;
+
+	for(y=0; y<h; y++)
 	{
 		p=((Uint8 *) s->pixels)+s->pitch*y;
-		op=o->pixels[0]+o->pitches[0]*y;
-		for(x=0; x<s->w && x<o->w; x++)
+		op=((Uint32 *) (((Uint8 *) d->pixels)+d->pitch*(area->y+y)))+area->x;
+		for(x=0; x<(w & ~7); x+=8, p+=8)
 		{
-			int c = *p++;
-			if(x%2==0)
-			{
-				*(op++)=p2y[c];
-				*(op++)=p2u[c];
-				op[1]=p2v[c];
-			}
-			else
-			{
-				*op=p2y[c];
-				op+=2;
-			}
+			op[0] = p2rgb32[p[0]];
+			op[1] = p2rgb32[p[1]];
+			op[2] = p2rgb32[p[2]];
+			op[3] = p2rgb32[p[3]];
+			op[4] = p2rgb32[p[4]];
+			op[5] = p2rgb32[p[5]];
+			op[6] = p2rgb32[p[6]];
+			op[7] = p2rgb32[p[7]];
+			op+=8;
+		}
+		for(; x<w; x++)
+		{
+			*op++ = p2rgb32[*p++];
 		}
 	}
 
-	SDL_UnlockYUVOverlay(o);
+	SDL_UnlockSurface(d);
 	SDL_UnlockSurface(s);
 }
 
@@ -10,6 +10,7 @@
 #include <SDL.h>
 
 void I_Pal2Yuv(SDL_Color *palette);
+void I_Pal2Rgb32(SDL_Color *palette, SDL_PixelFormat *format);
 
 void I_RGB8toYV12(SDL_Surface *s, SDL_Overlay *o);
 void I_RGB8toIYUV(SDL_Surface *s, SDL_Overlay *o);
@@ -17,6 +18,9 @@ void I_RGB8toUYVY(SDL_Surface *s, SDL_Overlay *o);
 void I_RGB8toYVYU(SDL_Surface *s, SDL_Overlay *o);
 void I_RGB8toYUY2(SDL_Surface *s, SDL_Overlay *o);
 
+/* 32 bits destination only, see I_Pal2Rgb32 */
+void I_RGB8toRGB32(SDL_Surface *s, SDL_Surface *d, SDL_Rect *area);
+
 void I_RGB32toYV12(SDL_Surface *s, SDL_Overlay *o);
 void I_RGB32toIYUV(SDL_Surface *s, SDL_Overlay *o);
 void I_RGB32toUYVY(SDL_Surface *s, SDL_Overlay *o);
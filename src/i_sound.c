@@ -54,24 +54,324 @@ typedef struct
 static sound_drv_t drv;
 
 i_sound_channel_t i_sound_channels[NUM_CHANNELS];
+int i_sound_numchannels = NUM_CHANNELS;
 
-// Pitch to stepping lookup, unused.
+// Pitch to stepping lookup.
 static int		steptable[256];
 
-// Volume lookups.
-static int *vol_lookup=NULL;
+//
+// Sound commands, from the game to the audio callback,
+//  and the other way round when a sample ends.
+// Each queue has a single writer and a single reader,
+//  which only moves its own index, so neither ever waits
+//  for the other, nor sees a half written command.
+//
+// Power of 2, several times NUM_CHANNELS: every channel may be
+//  updated each tic, while the callback reads them less often.
+#define SOUND_QUEUE_SIZE	256
+
+#if defined(__GNUC__) && defined(__m68k__)
+// A single processor, only the compiler may reorder.
+#define I_SOUND_BARRIER()	__asm__ __volatile__ ("" : : : "memory")
+#elif defined(__GNUC__)
+#define I_SOUND_BARRIER()	__sync_synchronize()
+#else
+#define I_SOUND_BARRIER()
+#endif
+
+typedef enum
+{
+    SNDCMD_START,
+    SNDCMD_STOP,
+    SNDCMD_UPDATE,
+    SNDCMD_DONE		// from the audio callback
+
+} soundcmdtype_t;
+
+typedef struct
+{
+    soundcmdtype_t	type;
+    int			channel;
+    int			handle;
+    int			id;
+    Uint8*		startp;
+    Uint32		length;
+    Uint32		step;
+    int			leftgain;
+    int			rightgain;
+
+} soundcmd_t;
+
+typedef struct
+{
+    soundcmd_t		cmds[SOUND_QUEUE_SIZE];
+    volatile unsigned	head;	// moved by the writer
+    volatile unsigned	tail;	// moved by the reader
+
+} soundqueue_t;
+
+static soundqueue_t	soundcommands;
+static soundqueue_t	soundevents;
+
+// Kept by the audio callback: the commands it applied,
+//  and how many channels mix each sound. The game only
+//  frees sounds none mixes, once all commands are applied.
+static volatile unsigned	soundapplied;
+static volatile int		sfxmixing[NUMSFX];
+static int			channelsfx[NUM_CHANNELS];
+
+//
+// What the game knows of the channels,
+//  the audio callback may be done with some.
+//
+typedef struct
+{
+    int		id;
+    int		start;	// gametic the channel started playing
+    int		handle;
+    boolean	playing;
+    boolean	stopping;	// the stop is yet to be queued
+    Uint32	step;		// as last sent
+    int		leftgain;
+    int		rightgain;
+
+} soundslot_t;
+
+static soundslot_t	soundslots[NUM_CHANNELS];
+
+
+//
+// Sound effects are resampled to the output rate when loaded,
+//  so most are mixed a sample at a time, and kept up to
+//  sysaudio.kb_sfx KB, the least recently started ones
+//  being freed first.
+// The resampling is a Lanczos windowed sinc, its taps
+//  for each of SFX_PHASES positions between two samples
+//  precomputed for the current rates.
+//
+#define SFX_LOBES	4
+#define SFX_PHASEBITS	6
+#define SFX_PHASES	(1<<SFX_PHASEBITS)
+#define SFX_ONEBITS	14
+
+#ifndef M_PI
+#define M_PI		3.14159265358979323846
+#endif
+
+static int*		sfxkernel;	// [SFX_PHASES][sfxtaps]
+static int		sfxtaps;
+static int		sfxkernelin;
+static int		sfxkernelout;
+
+static int		sfxlastuse[NUMSFX];
+static int		sfxuses;
+static int		sfxbytes;
+
+
+//
+// I_Lanczos
+//
+static double I_Lanczos(double x)
+{
+	double	px;
+
+	if (x == 0.0) {
+		return 1.0;
+	}
+	if (x <= -SFX_LOBES || x >= SFX_LOBES) {
+		return 0.0;
+	}
+
+	px = M_PI * x;
+	return SFX_LOBES * sin(px) * sin(px/SFX_LOBES) / (px*px);
+}
+
+
+//
+// I_InitSfxKernel
+// Going down in rate, the kernel is widened to
+//  cut what the output rate can not hold.
+//
+static void I_InitSfxKernel(int inrate, int outrate)
+{
+	double	scale;
+	double	taps[SFX_LOBES*2*8];
+	double	total;
+	int		half;
+	int		phase;
+	int		i;
+
+	if (sfxkernel && inrate == sfxkernelin && outrate == sfxkernelout) {
+		return;
+	}
+
+	scale = 1.0;
+	if (outrate < inrate) {
+		scale = (double) outrate / inrate;
+		if (scale < 1.0/8) {
+			scale = 1.0/8;
+		}
+	}
+
+	half = (int) ceil(SFX_LOBES / scale);
+	sfxtaps = half*2;
+
+	if (sfxkernel) {
+		Z_Free(sfxkernel);
+	}
+	sfxkernel = Z_Malloc(SFX_PHASES*sfxtaps*sizeof(int), PU_STATIC, NULL);
+	sfxkernelin = inrate;
+	sfxkernelout = outrate;
+
+	for (phase=0; phase<SFX_PHASES; phase++) {
+		// Tap i is for sample i-half+1 of the position.
+		total = 0.0;
+		for (i=0; i<sfxtaps; i++) {
+			taps[i] = I_Lanczos((i-half+1 - (double) phase/SFX_PHASES) * scale);
+			total += taps[i];
+		}
+
+		// Each phase keeps the level of the sound.
+		for (i=0; i<sfxtaps; i++) {
+			sfxkernel[phase*sfxtaps + i] =
+				(int) floor(taps[i]/total * (1<<SFX_ONEBITS) + 0.5);
+		}
+	}
+}
+
+
+//
+// I_ResampleSfx
+// Returns the 8 bits unsigned samples of source at the output rate,
+//  in a block of its own.
+//
+static byte*
+I_ResampleSfx
+( byte*		source,
+  int		length,
+  int		inrate,
+  int*		outlength )
+{
+	byte*	dest;
+	int*	taps;
+	int		outrate;
+	int		count;
+	int		half;
+	int		pos;
+	int		frac;
+	int		stepint;
+	int		stepfrac;
+	int		sum;
+	int		first;
+	int		i;
+	int		j;
+
+	outrate = sysaudio.obtained.freq;
+	count = (int) ceil((double) length * outrate / inrate);
+
+	dest = Z_Malloc(count, PU_STATIC, NULL);
+	*outlength = count;
+
+	if (inrate == outrate) {
+		memcpy(dest, source, length);
+		return dest;
+	}
+
+	I_InitSfxKernel(inrate, outrate);
+	half = sfxtaps/2;
+
+	stepint = inrate / outrate;
+	stepfrac = (int) (((unsigned) (inrate % outrate) << 16) / outrate);
+
+	pos = 0;
+	frac = 0;
+	for (i=0; i<count; i++) {
+		taps = sfxkernel + (frac >> (16-SFX_PHASEBITS))*sfxtaps;
+		first = pos - half + 1;
+
+		// Silence around the sound.
+		sum = 0;
+		for (j=0; j<sfxtaps; j++) {
+			if (first+j >= 0 && first+j < length) {
+				sum += (source[first+j] - 128) * taps[j];
+			}
+		}
+
+		sum = (sum + (1<<(SFX_ONEBITS-1))) >> SFX_ONEBITS;
+		if (sum < -128) {
+			sum = -128;
+		} else if (sum > 127) {
+			sum = 127;
+		}
+		dest[i] = sum + 128;
+
+		frac += stepfrac;
+		pos += stepint + (frac >> 16);
+		frac &= 0xffff;
+	}
+
+	return dest;
+}
+
+
+//
+// I_FreeSfx
+// Frees the least recently started sounds, not playing,
+//  till the budget is met.
+//
+static void I_FreeSfx(void)
+{
+	int		budget;
+	int		oldest;
+	int		i;
+
+	budget = sysaudio.kb_sfx*1024;
+
+	// Not from under the mixer: a queued start may
+	//  still give it a sound.
+	if (sfxbytes <= budget || soundapplied != soundcommands.head) {
+		return;
+	}
+	I_SOUND_BARRIER();
+
+	while (sfxbytes > budget) {
+		oldest = -1;
+		for (i=1; i<NUMSFX; i++) {
+			if (!S_sfx[i].data || S_sfx[i].usefulness > 0
+				|| sfxmixing[i] > 0) {
+				continue;
+			}
+
+			if (oldest < 0 || sfxlastuse[i] < sfxlastuse[oldest]) {
+				oldest = i;
+			}
+		}
+
+		if (oldest < 0) {
+			return;
+		}
+
+		Z_Free(S_sfx[oldest].data);
+		sfxbytes -= S_sfx[oldest].length;
+		S_sfx[oldest].data = NULL;
+		S_sfx[oldest].usefulness = -1;
+	}
+}
+
 
 //
 // This function loads the sound data from the WAD lump,
-//  for single sound.
+//  for single sound, at the output rate.
 //
 void*
 I_LoadSfx
-( char*         sfxname,
+( sfxinfo_t*    sfx,
   int*          len )
 {
-    unsigned char*      sfx;
+    byte*               lump;
+    byte*               data;
     int                 size;
+    int                 rate;
     char                name[20];
     int                 sfxlump;
     
@@ -80,7 +380,7 @@ I_LoadSfx
 
     // Get the sound data from the WAD, allocate lump
     //  in zone memory.
-    sprintf(name, "ds%s", sfxname);
+    sprintf(name, "ds%s", sfx->name);
 
     // Now, there is a severe problem with the
     //  sound handling, in it is not (yet/anymore)
@@ -98,21 +398,226 @@ I_LoadSfx
       sfxlump = W_GetNumForName(name);
     
     size = W_LumpLength( sfxlump );
+    lump = (byte*)W_CacheLumpNum( sfxlump, PU_STATIC );
 
+	// 8 bytes header, with the rate of the sound.
+	rate = lump[2] | (lump[3]<<8);
+	if (!rate)
+		rate = SAMPLERATE;
 
-    // Debug.
-    // fprintf( stderr, "." );
-    //fprintf( stderr, " -loading  %s (lump %d, %d bytes)\n",
-    //	     sfxname, sfxlump, size );
-    //fflush( stderr );
-    
-    sfx = (unsigned char*)W_CacheLumpNum( sfxlump, PU_STATIC );
+	data = I_ResampleSfx(lump+8, size-8, rate, len);
+	W_ReleaseLumpNum(sfxlump);
+
+	sfxbytes += *len;
+	sfxlastuse[sfx - S_sfx] = ++sfxuses;
+	I_FreeSfx();
+
+    return data;
+}
+
+
+//
+// I_WriteSoundQueue
+// Returns false, and drops the command, if the queue is full.
+//
+static boolean I_WriteSoundQueue (soundqueue_t* queue, soundcmd_t* cmd)
+{
+    unsigned	head;
+
+    head = queue->head;
+    if (head - queue->tail >= SOUND_QUEUE_SIZE)
+	return false;
+
+    queue->cmds[head & (SOUND_QUEUE_SIZE-1)] = *cmd;
+    I_SOUND_BARRIER();
+    queue->head = head + 1;
+
+    return true;
+}
+
+
+//
+// I_ReadSoundQueue
+// Returns false if the queue is empty.
+//
+static boolean I_ReadSoundQueue (soundqueue_t* queue, soundcmd_t* cmd)
+{
+    unsigned	tail;
+
+    tail = queue->tail;
+    if (tail == queue->head)
+	return false;
+
+    I_SOUND_BARRIER();
+    *cmd = queue->cmds[tail & (SOUND_QUEUE_SIZE-1)];
+    I_SOUND_BARRIER();
+    queue->tail = tail + 1;
+
+    return true;
+}
+
+
+//
+// I_ReadSoundCommands
+// Applies the game commands to the channels,
+//  before the audio callback mixes them.
+//
+void I_ReadSoundCommands(void)
+{
+	soundcmd_t	cmd;
+	i_sound_channel_t*	channel;
+
+	while (I_ReadSoundQueue(&soundcommands, &cmd)) {
+		channel = &i_sound_channels[cmd.channel];
+
+		switch (cmd.type) {
+			case SNDCMD_START:
+				if (channel->startp) {
+					sfxmixing[channelsfx[cmd.channel]]--;
+				}
+				channelsfx[cmd.channel] = cmd.id;
+				sfxmixing[cmd.id]++;
+				channel->startp = cmd.startp;
+				channel->end = cmd.startp + cmd.length;
+				channel->length = cmd.length;
+				channel->position = 0;
+				channel->step = cmd.step;
+				channel->stepremainder = 0;
+				channel->handle = cmd.handle;
+				channel->leftgain = cmd.leftgain;
+				channel->rightgain = cmd.rightgain;
+				break;
 
-	*len = size-8;
+			case SNDCMD_STOP:
+				if (channel->startp) {
+					sfxmixing[channelsfx[cmd.channel]]--;
+				}
+				channel->startp = NULL;
+				break;
+
+			case SNDCMD_UPDATE:
+				if (channel->handle == cmd.handle) {
+					channel->step = cmd.step;
+					channel->leftgain = cmd.leftgain;
+					channel->rightgain = cmd.rightgain;
+				}
+				break;
+
+			default:
+				break;
+		}
+
+		I_SOUND_BARRIER();
+		soundapplied++;
+	}
+}
+
+
+//
+// I_SoundDone
+// Tells the game the channel is free.
+//
+void I_SoundDone(i_sound_channel_t* channel)
+{
+	soundcmd_t	cmd;
+
+	sfxmixing[channelsfx[channel - i_sound_channels]]--;
+	channel->startp = NULL;
+
+	cmd.type = SNDCMD_DONE;
+	cmd.channel = channel - i_sound_channels;
+	cmd.handle = channel->handle;
+	I_WriteSoundQueue(&soundevents, &cmd);
+}
+
+
+//
+// I_ReadSoundEvents
+// Frees the channels the audio callback is done with.
+//
+static void I_ReadSoundEvents(void)
+{
+	soundcmd_t	cmd;
+	soundslot_t*	slot;
+
+	while (I_ReadSoundQueue(&soundevents, &cmd)) {
+		slot = &soundslots[cmd.channel];
+
+		// Not if the channel was given another sound since.
+		if (slot->playing && slot->handle == cmd.handle) {
+			if (!slot->stopping) {
+				S_sfx[slot->id].usefulness--;
+			}
+			slot->playing = false;
+			slot->stopping = false;
+		}
+	}
+}
+
+
+//
+// I_StopSlot
+// With the queue full, the slot stays busy, and the
+//  stop is queued again next tic by I_UpdateSounds.
+//
+static void I_StopSlot(int slot)
+{
+	soundcmd_t	cmd;
+	soundslot_t*	s;
+
+	s = &soundslots[slot];
+	if (s->playing && !s->stopping) {
+		S_sfx[s->id].usefulness--;
+	}
+
+	cmd.type = SNDCMD_STOP;
+	cmd.channel = slot;
+	if (I_WriteSoundQueue(&soundcommands, &cmd)) {
+		s->playing = false;
+		s->stopping = false;
+	} else {
+		s->playing = true;
+		s->stopping = true;
+	}
+}
+
+
+//
+// I_SoundGains
+// Per left/right channel gains, for the mixers.
+//
+static void
+I_SoundGains
+( soundcmd_t*	cmd,
+  int		volume,
+  int		seperation )
+{
+	int		rightvol;
+	int		leftvol;
+
+	// Separation, that is, orientation/stereo.
+	//  range is: 1 - 256
+	seperation += 1;
+
+	// Per left/right channel.
+	//  x^2 seperation,
+	//  adjust volume properly.
+	leftvol = volume - ((volume*seperation*seperation) >> 16); ///(256*256);
+	seperation = seperation - 257;
+	rightvol = volume - ((volume*seperation*seperation) >> 16);	
+
+    if (leftvol < 0) leftvol = 0;
+    else if (leftvol > 127) leftvol = 127;
+    if (rightvol < 0) rightvol = 0;
+    else if (rightvol > 127) rightvol = 127;
 
-    return (sfx+8);
+	// Gains also turn the unsigned samples into
+	//  signed 16 bits samples, 127 giving 256.
+	cmd->leftgain = (leftvol*256 + 63) / 127;
+	cmd->rightgain = (rightvol*256 + 63) / 127;
 }
 
+
 //
 // This function adds a sound to the
 //  list of currently active sounds,
@@ -136,22 +641,23 @@ addsfx
 	int		oldestnum = 0;
 	int		slot;
 
-	int		rightvol;
-	int		leftvol;
+	soundcmd_t	cmd;
 
 	if (!sysaudio.sound_enabled)
 		return -1;
 
+	I_ReadSoundEvents();
+
 	// Chainsaw troubles.
 	// Play these sound effects only one at a time.
 	if ( sfxid == sfx_sawup || sfxid == sfx_sawidl || sfxid == sfx_sawful
 		|| sfxid == sfx_sawhit || sfxid == sfx_stnmov || sfxid == sfx_pistol) {
 		// Loop all channels, check.
-		for (i=0 ; i<NUM_CHANNELS ; i++) {
+		for (i=0 ; i<i_sound_numchannels ; i++) {
 			// Active, and using the same SFX?
-			if ( (i_sound_channels[i].startp) && (i_sound_channels[i].id == sfxid) ) {
+			if ( (soundslots[i].playing) && (soundslots[i].id == sfxid) ) {
 				// Reset.
-				i_sound_channels[i].startp = NULL;
+				I_StopSlot(i);
 				// We are sure that iff,
 				//  there will only be one.
 				break;
@@ -160,10 +666,10 @@ addsfx
 	}
 
 	// Loop all channels to find oldest SFX.
-	for (i=0; (i<NUM_CHANNELS) && (i_sound_channels[i].startp); i++) {
-		if (i_sound_channels[i].start < oldest) {
+	for (i=0; (i<i_sound_numchannels) && (soundslots[i].playing); i++) {
+		if (soundslots[i].start < oldest) {
 			oldestnum = i;
-			oldest = i_sound_channels[i].start;
+			oldest = soundslots[i].start;
 		}
 	}
 
@@ -171,73 +677,51 @@ addsfx
 	// If we found a channel, fine.
 	// If not, we simply overwrite the first one, 0.
 	// Probably only happens at startup.
-	if (i == NUM_CHANNELS)
+	if (i == i_sound_numchannels)
 		slot = oldestnum;
 	else
 		slot = i;
 
 	/* Decrease usefulness of sample on channel 'slot' */
-	if (i_sound_channels[slot].startp) {
-		S_sfx[i_sound_channels[slot].id].usefulness--;
+	if (soundslots[slot].playing && !soundslots[slot].stopping) {
+		S_sfx[soundslots[slot].id].usefulness--;
 	}
 
-	// Okay, in the less recent channel,
-	//  we will handle the new SFX.
-	// Set pointer to raw data.
-	i_sound_channels[slot].startp = (unsigned char *) S_sfx[sfxid].data;
-
-	// Set pointer to end of raw data.
-	i_sound_channels[slot].end = S_sfx[sfxid].data + S_sfx[sfxid].length;
-
-	i_sound_channels[slot].position = 0;
-	i_sound_channels[slot].length = S_sfx[sfxid].length;
-
 	// Reset current handle number, limited to 0..100.
 	if (!handlenums)
 		handlenums = 100;
 
+	// Okay, in the less recent channel,
+	//  we will handle the new SFX.
+	cmd.type = SNDCMD_START;
+	cmd.channel = slot;
+	cmd.startp = (Uint8 *) S_sfx[sfxid].data;
+	cmd.length = S_sfx[sfxid].length;
 	// Assign current handle number.
-	// Preserved so sounds could be stopped (unused).
-	i_sound_channels[slot].handle = rc = handlenums++;
-
-	// Set stepping???
-	// Kinda getting the impression this is never used.
-	i_sound_channels[slot].step = step;
-	// ???
-	i_sound_channels[slot].stepremainder = 0;
-	// Should be gametic, I presume.
-	i_sound_channels[slot].start = gametic;
-
-	// Separation, that is, orientation/stereo.
-	//  range is: 1 - 256
-	seperation += 1;
-
-	// Per left/right channel.
-	//  x^2 seperation,
-	//  adjust volume properly.
-	leftvol = volume - ((volume*seperation*seperation) >> 16); ///(256*256);
-	seperation = seperation - 257;
-	rightvol = volume - ((volume*seperation*seperation) >> 16);	
-
-    if (leftvol < 0) leftvol = 0;
-    else if (leftvol > 127) leftvol = 127;
-    if (rightvol < 0) rightvol = 0;
-    else if (rightvol > 127) rightvol = 127;
-#if 0
-	// Sanity check, clamp volume.
-	if (rightvol < 0 || rightvol > 127)
-		I_Error("rightvol out of bounds");
-
-	if (leftvol < 0 || leftvol > 127)
-		I_Error("leftvol out of bounds");
-#endif
-
-	i_sound_channels[slot].leftvol_lookup = &vol_lookup[leftvol*256];
-	i_sound_channels[slot].rightvol_lookup = &vol_lookup[rightvol*256];
+	cmd.handle = rc = handlenums++;
+	cmd.id = sfxid;
+	cmd.step = step;
+	I_SoundGains(&cmd, volume, seperation);
+
+	// Full, the sound is not heard, and the one
+	//  it replaces is stopped next tic.
+	if (!I_WriteSoundQueue(&soundcommands, &cmd)) {
+		soundslots[slot].stopping = soundslots[slot].playing;
+		return -1;
+	}
 
+	soundslots[slot].playing = true;
+	soundslots[slot].stopping = false;
+	soundslots[slot].step = cmd.step;
+	soundslots[slot].leftgain = cmd.leftgain;
+	soundslots[slot].rightgain = cmd.rightgain;
+	soundslots[slot].handle = rc;
+	// Should be gametic, I presume.
+	soundslots[slot].start = gametic;
 	// Preserve sound SFX id,
 	//  e.g. for avoiding duplicates of chainsaw.
-	i_sound_channels[slot].id = sfxid;
+	soundslots[slot].id = sfxid;
+	sfxlastuse[sfxid] = ++sfxuses;
 
 	// You tell me.
 	return rc;
@@ -249,14 +733,15 @@ void I_UpdateSounds(void)
         return;
     }
 
-	for (int i=0;i<NUM_CHANNELS;i++) {
-		int sfxid = i_sound_channels[i].id;
-		if ((S_sfx[sfxid].usefulness <= 0) && S_sfx[sfxid].data) {
-		    Z_ChangeTag(S_sfx[sfxid].data - 8, PU_CACHE);
-			S_sfx[sfxid].usefulness = 0;
-		    S_sfx[sfxid].data = NULL;
-	    }
+	I_ReadSoundEvents();
+
+	for (int i=0; i<NUM_CHANNELS; i++) {
+		if (soundslots[i].stopping) {
+			I_StopSlot(i);
+		}
 	}
+
+	I_FreeSfx();
 }
 
 
@@ -270,33 +755,28 @@ void I_UpdateSounds(void)
 // version.
 // See soundserver initdata().
 //
-void I_SetChannels()
+void I_SetChannels(int channels)
 {
     if (!sysaudio.sound_enabled) {
         return;
     }
 
+	if (channels < 1) {
+		channels = 1;
+	} else if (channels > NUM_CHANNELS) {
+		channels = NUM_CHANNELS;
+	}
+	i_sound_numchannels = channels;
+
 	for (int i=0; i<NUM_CHANNELS; i++) {
-		i_sound_channels[i].startp = NULL;
+		I_StopSlot(i);
     }
 
 	// This table provides step widths for pitch parameters.
-	// I fail to see that this is currently used.
+	// Sounds are already at the output rate.
 	for (int i=-128 ; i<128 ; i++) {
-		int newstep = (int)(pow(2.0, (i/64.0))*65536.0);
-		newstep = (newstep*11025)/sysaudio.obtained.freq;
-		steptable[i+128] = newstep;
+		steptable[i+128] = (int)(pow(2.0, (i/64.0))*65536.0);
 	}
-
-	// Generates volume lookup tables
-	//  which also turn the unsigned samples
-	//  into signed samples.
-	vol_lookup = Z_Malloc(128*256*sizeof(int), PU_STATIC, NULL);
-	for (int i=0 ; i<128 ; i++) {
-		for (int j=0 ; j<256 ; j++) {
-			vol_lookup[i*256+j] = (i*(j-128)*256)/127;
-        }
-    }
 }	
 
  
@@ -353,22 +833,40 @@ I_StartSound
 
 
 
+//
+// I_FindSlot
+// Returns the channel playing the sound of handle, or -1.
+//
+static int I_FindSlot(int handle)
+{
+	I_ReadSoundEvents();
+
+	for (int i=0; i<i_sound_numchannels; i++) {
+		if (soundslots[i].playing && !soundslots[i].stopping
+			&& soundslots[i].handle == handle) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+
 void I_StopSound (int handle)
 {
-	// You need the handle returned by StartSound.
-	// Would be looping all channels,
-	//  tracking down the handle,
-	//  an setting the channel to zero.
+	int slot;
 
-	// UNUSED.
-	handle = 0;
+	// You need the handle returned by StartSound.
+	slot = I_FindSlot(handle);
+	if (slot >= 0) {
+		I_StopSlot(slot);
+	}
 }
 
 
 int I_SoundIsPlaying(int handle)
 {
-	// Ouch.
-	return gametic < handle;
+	return I_FindSlot(handle) >= 0;
 }
 
 
@@ -399,13 +897,33 @@ I_UpdateSoundParams
   int	sep,
   int	pitch)
 {
-  // I fail too see that this is used.
-  // Would be using the handle to identify
-  //  on which channel the sound might be active,
-  //  and resetting the channel parameters.
+	soundcmd_t	cmd;
+	soundslot_t*	slot;
+
+	cmd.channel = I_FindSlot(handle);
+	if (cmd.channel < 0) {
+		return;
+	}
 
-  // UNUSED.
-  handle = vol = sep = pitch = 0;
+	// The audio callback checks the handle,
+	//  the sound may have ended meanwhile.
+	cmd.type = SNDCMD_UPDATE;
+	cmd.handle = handle;
+	cmd.step = steptable[pitch];
+	I_SoundGains(&cmd, vol, sep);
+
+	// Most sounds do not move every tic.
+	slot = &soundslots[cmd.channel];
+	if (cmd.step == slot->step && cmd.leftgain == slot->leftgain
+		&& cmd.rightgain == slot->rightgain) {
+		return;
+	}
+
+	if (I_WriteSoundQueue(&soundcommands, &cmd)) {
+		slot->step = cmd.step;
+		slot->leftgain = cmd.leftgain;
+		slot->rightgain = cmd.rightgain;
+	}
 }
 
 void I_ShutdownSound(void)
@@ -28,15 +28,18 @@
 int I_InitSound();
 void I_UpdateSound(void *unused, Uint8 *stream, int len);
 void I_ShutdownSound(void);
-void I_SetChannels();
+void I_SetChannels(int channels);
 int I_GetSfxLumpNum (sfxinfo_t* sfxinfo );
 int I_StartSound(int id, int vol, int sep, int pitch, int priority);
 void I_StopSound(int handle);
 int I_SoundIsPlaying(int handle);
 void I_UpdateSoundParams(int handle, int vol, int sep, int pitch);
-void* I_LoadSfx(char* sfxname, int* len);
+void* I_LoadSfx(sfxinfo_t* sfx, int* len);
 void I_UpdateSounds(void);
 
+// Called by the mixers, from the audio callback.
+void I_ReadSoundCommands(void);
+
 
 typedef struct {
     Uint8*  startp;
@@ -46,15 +49,20 @@ typedef struct {
 
 	Uint32  step;
 	Uint32  stepremainder;	// or position.frac for m68k asm rout
-	int     start;          // Time/gametic that the channel started playing,
 	int     handle;
-	int		id;			
 
-    int*    leftvol_lookup;
-    int*    rightvol_lookup;
+    /* (sample-128)*gain is a 16 bits sample */
+    int     leftgain;
+    int     rightgain;
 
 } i_sound_channel_t;
 
+// Only the audio callback touches these,
+//  the game sends them commands.
 extern i_sound_channel_t i_sound_channels[NUM_CHANNELS];
+extern int i_sound_numchannels;
+
+// Called by the mixers when the sample of channel ends.
+void I_SoundDone(i_sound_channel_t* channel);
 
 #endif
@@ -253,23 +253,23 @@ void vbl_blaster(void) {
         timerA_enable(false);
     }
 
+    I_ReadSoundCommands();
+
     if (howmuch >= 16)
     {
         memset(tmpMixBuffer, 0, howmuch<<2);
 
         uint16_t written = 0;
-        for ( int chan = 0; chan < NUM_CHANNELS; chan++ ) {
+        for ( int chan = 0; chan < i_sound_numchannels; chan++ ) {
             i_sound_channel_t* channel = &i_sound_channels[chan];
             if (channel->startp) {
                 int32_t srclen = (channel->length - channel->position) - 4;
                 if (srclen <= 0) {
-                    channel->startp = NULL;
-                    S_sfx[channel->id].usefulness--;
+                    I_SoundDone(channel);
                     continue;
                 }
 
-                int32_t* leftvol = channel->leftvol_lookup;
-                int32_t* rightvol = channel->rightvol_lookup;
+                int32_t gain = channel->leftgain + channel->rightgain;
 
                 int32_t qu = howmuch > srclen ? srclen : howmuch;
                 if (qu > written) { written = qu; }
@@ -277,8 +277,8 @@ void vbl_blaster(void) {
                 int32_t* writeptr = tmpMixBuffer;
                 volatile uint8_t* readptr = channel->startp + channel->position;
                 for (int32_t i = 0; i < qu; i++) {
-                    uint8_t sample = (unsigned int) (*readptr++);
-                    *writeptr++ += (leftvol[sample] + rightvol[sample]);
+                    int32_t sample = (int32_t) (*readptr++) - 128;
+                    *writeptr++ += sample * gain;
                 }
                 channel->position += qu;
             }
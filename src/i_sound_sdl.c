@@ -46,179 +46,313 @@ static Sint16 *tmpMixBuffer2 = NULL;	/* 16bit clipped mixing buffer for conv */
 static int tmpMixBuffLen = 0;
 static SDL_bool quit = SDL_FALSE;
 
+/* What I_WriteMix writes to the stream */
+enum {
+	MIX_S16,		/* 16 bits stereo, native endian */
+	MIX_S16ADD,		/* same, added to SDL_mixer music */
+	MIX_S16MONO,
+	MIX_U8,
+	MIX_U8MONO,
+	MIX_CONVERT		/* 16 bits stereo through SDL_ConvertAudio */
+};
+
+static int mixFormat = MIX_CONVERT;
+
+#define I_CLIP16(v) \
+	((v) > 0x7fff ? 0x7fff : ((v) < -0x8000 ? -0x8000 : (v)))
+
+#if defined(__GNUC__) && defined(__m68k__)
+#define I_STEPSAMPLE \
+	__asm__ __volatile__ (	\
+			"addl	%3,%1\n"	\
+		"	addxl	%2,%0"	\
+	 	: /* output */	\
+			"=d"(position), "=d"(stepremainder)	\
+	 	: /* input */	\
+			"d"(step_int), "r"(step_frac), "d"(position), "d"(stepremainder)	\
+	 	: /* clobbered registers */	\
+	 		"cc"	\
+	);
+#else
+#define I_STEPSAMPLE \
+	stepremainder += step;	\
+	position += stepremainder >> 16;	\
+	stepremainder &= 65536-1;
+#endif
+
+/*
+ * Mixes a channel with OP, = for the first one, += for the others.
+ * Without resampling, the loop is a plain multiply add.
+ */
+#define I_MIXSAMPLES(OP) \
+	if (step == 65536) {	\
+		sample += position;	\
+		for (i=0; i<count; i++) {	\
+			val = sample[i] - 128;	\
+			mix[i*2] OP val*leftgain;	\
+			mix[i*2+1] OP val*rightgain;	\
+		}	\
+		position += count;	\
+	} else {	\
+		for (i=0; i<count; i++) {	\
+			val = sample[position] - 128;	\
+			mix[i*2] OP val*leftgain;	\
+			mix[i*2+1] OP val*rightgain;	\
+			I_STEPSAMPLE	\
+		}	\
+	}
+
 
 //
-// This function loops all active (internal) sound
-//  channels, retrieves a given number of samples
-//  from the raw sound data, modifies it according
-//  to the current (internal) channel parameters,
-//  mixes the per channel samples into the global
-//  mixbuffer, clamping it to the allowed range,
-//  and sets up everything for transferring the
-//  contents of the mixbuffer to the (two)
-//  hardware channels (left and right, that is).
-//
-// This function currently supports only 16bit.
+// I_MixChannel
+// Mixes up to count stereo samples of the channel in mix,
+//  storing them if first, adding them otherwise.
+// Returns the number of samples mixed.
 //
-void I_UpdateSound_SDL(void *unused, Uint8 *stream, int len)
+static int I_MixChannel(i_sound_channel_t *channel, Sint32 *mix, int count,
+	boolean first)
 {
-	int i, chan, srclen;
-	boolean mixToFinal = false;
-	Sint32 *source;
-	Sint16 *dest;
+	Uint8 *sample;
+	Uint32 position, stepremainder, step;
+	int leftgain, rightgain;
+	int i, val;
+	Sint32 maxlen;
+	boolean done = false;
+#if defined(__GNUC__) && defined(__m68k__)
+	Uint32 step_int, step_frac;
+#endif
 
-	if (quit) {
-		return;
+	sample = channel->startp;
+	position = channel->position;
+	stepremainder = channel->stepremainder;
+	step = channel->step;
+	leftgain = channel->leftgain;
+	rightgain = channel->rightgain;
+#if defined(__GNUC__) && defined(__m68k__)
+	step_int = step>>16;
+	step_frac = step<<16;
+#endif
+
+	maxlen = FixedDiv(channel->length-position, step);
+	if (count > maxlen) {
+		count = maxlen;
+		done = true;
 	}
 
-	memset(tmpMixBuffer, 0, tmpMixBuffLen);
-	srclen = len;
-	if (sysaudio.convert) {
-		srclen = (int) (len / sysaudio.audioCvt.len_ratio);
+	if (first) {
+		I_MIXSAMPLES(=)
+	} else {
+		I_MIXSAMPLES(+=)
 	}
 
-	/* Add each channel to tmp mix buffer */
-	for ( chan = 0; chan < NUM_CHANNELS; chan++ ) {
-		Uint8 *sample;
-		Uint32 position, stepremainder, step;
-		int *leftvol, *rightvol;
-		Sint32 maxlen;
-		SDL_bool end_of_sample;
+	channel->position = position;
+	channel->stepremainder = stepremainder;
 
-		// Check channel, if active.
-		if (!i_sound_channels[ chan ].startp) {
-			continue;
-		}
+	// Once the sample is not read any more
+	if (done) {
+		I_SoundDone(channel);
+	}
 
-		source = tmpMixBuffer;
-		sample = i_sound_channels[chan].startp;
-		position = i_sound_channels[ chan ].position;
-		stepremainder = i_sound_channels[chan].stepremainder;
-		step = i_sound_channels[chan].step;
-		leftvol = i_sound_channels[chan].leftvol_lookup;
-		rightvol = i_sound_channels[chan].rightvol_lookup;
-
-		maxlen = FixedDiv(i_sound_channels[chan].length-position, step);
-		end_of_sample = SDL_FALSE;
-		if ((srclen>>2) <= maxlen) {
-			maxlen = srclen>>2;
-		} else {
-			end_of_sample = SDL_TRUE;
-		}
+	return count;
+}
 
-		{
-#if defined(__GNUC__) && defined(__m68k__)
-			Uint32	step_int = step>>16;
-			Uint32	step_frac = step<<16;
-#endif
-			for (i=0; i<maxlen; i++) {
-				unsigned int val;
 
-				// Get the raw data from the channel. 
-				val = sample[position];
+//
+// I_WriteMix
+// Clips the mixed samples, and writes them in the format
+//  of the stream, all in one pass.
+//
+static void I_WriteMix(Sint32 *mix, Uint8 *stream, int count)
+{
+	Sint16 *dest;
+	Sint32 dl, dr;
+	int i;
 
-				// Add left and right part
-				//  for this channel (sound)
-				//  to the current data.
-				// Adjust volume accordingly.
-				*source++ += leftvol[val];
-				*source++ += rightvol[val];
+	switch (mixFormat) {
+		case MIX_S16:
+			dest = (Sint16 *) stream;
+			for (i=0; i<count*2; i++) {
+				dl = mix[i];
+				dest[i] = I_CLIP16(dl);
+			}
+			break;
+		case MIX_S16ADD:
+			dest = (Sint16 *) stream;
+			for (i=0; i<count*2; i++) {
+				dl = mix[i] + dest[i];
+				dest[i] = I_CLIP16(dl);
+			}
+			break;
+		case MIX_S16MONO:
+			dest = (Sint16 *) stream;
+			for (i=0; i<count; i++) {
+				dl = (mix[i*2] + mix[i*2+1]) >> 1;
+				dest[i] = I_CLIP16(dl);
+			}
+			break;
+		case MIX_U8:
+			for (i=0; i<count*2; i++) {
+				dl = mix[i];
+				stream[i] = (I_CLIP16(dl) >> 8) ^ 0x80;
+			}
+			break;
+		case MIX_U8MONO:
+			for (i=0; i<count; i++) {
+				dl = (mix[i*2] + mix[i*2+1]) >> 1;
+				stream[i] = (I_CLIP16(dl) >> 8) ^ 0x80;
+			}
+			break;
+		default:
+			dest = tmpMixBuffer2;
+			for (i=0; i<count; i++) {
+				dl = mix[i*2];
+				dr = mix[i*2+1];
+				dest[i*2] = I_CLIP16(dl);
+				dest[i*2+1] = I_CLIP16(dr);
+			}
 
-#if defined(__GNUC__) && defined(__m68k__)
-				__asm__ __volatile__ (
-						"addl	%3,%1\n"	\
-					"	addxl	%2,%0"	\
-				 	: /* output */
-						"=d"(position), "=d"(stepremainder)
-				 	: /* input */
-						"d"(step_int), "r"(step_frac), "d"(position), "d"(stepremainder)
-				 	: /* clobbered registers */
-				 		"cc"
-				);
-#else
-				// Increment index ???
-				stepremainder += step;
+			sysaudio.audioCvt.buf = (Uint8 *) tmpMixBuffer2;
+			sysaudio.audioCvt.len = count*4;
+			SDL_ConvertAudio(&sysaudio.audioCvt);
 
-				// MSB is next sample???
-				position += stepremainder >> 16;
+			SDL_MixAudio(stream, sysaudio.audioCvt.buf,
+				sysaudio.audioCvt.len_cvt, SDL_MIX_MAXVOLUME);
+			break;
+	}
+}
 
-				// Limit to LSB???
-				stepremainder &= 65536-1;
-#endif
-			}
-		}
 
-		if (end_of_sample) {
-			i_sound_channels[ chan ].startp = NULL;
-			S_sfx[i_sound_channels[chan].id].usefulness--;
-		}
-		i_sound_channels[ chan ].position = position;
-		i_sound_channels[ chan ].stepremainder = stepremainder;
+//
+// This function loops all active (internal) sound
+//  channels, mixing them with their own left and
+//  right gains in a 32 bits buffer: the first one
+//  stores, the next ones add.
+// The mix is then clipped and written to the
+//  stream in its own format at once.
+//
+void I_UpdateSound_SDL(void *unused, Uint8 *stream, int len)
+{
+	int chan, count, mixed, written;
+
+	if (quit) {
+		return;
 	}
 
-	/* Now clip values for final buffer */
-	source = tmpMixBuffer;	
-	if (sysaudio.convert) {
-		dest = (Sint16 *) tmpMixBuffer2;
-	} else {
-		dest = (Sint16 *) stream;
-#ifdef ENABLE_SDLMIXER
-		mixToFinal = true;
-#endif
+	I_ReadSoundCommands();
+
+	switch (mixFormat) {
+		case MIX_S16:
+		case MIX_S16ADD:
+		case MIX_U8:
+			count = len>>2;
+			if (mixFormat == MIX_U8)
+				count = len>>1;
+			break;
+		case MIX_S16MONO:
+			count = len>>1;
+			break;
+		case MIX_U8MONO:
+			count = len;
+			break;
+		default:
+			count = ((int) (len / sysaudio.audioCvt.len_ratio))>>2;
+			break;
+	}
+	if (count > tmpMixBuffLen>>3) {
+		count = tmpMixBuffLen>>3;
 	}
 
-	if (mixToFinal) {
-		for (i=0; i<srclen>>2; i++) {
-			Sint32 dl, dr;
+	/* Mix each channel in tmp mix buffer */
+	written = 0;
+	for ( chan = 0; chan < i_sound_numchannels; chan++ ) {
+		// Check channel, if active.
+		if (!i_sound_channels[ chan ].startp) {
+			continue;
+		}
 
-			dl = *source++ + dest[0];
-			dr = *source++ + dest[1];
+		mixed = I_MixChannel(&i_sound_channels[chan], tmpMixBuffer,
+			count, written == 0);
 
-			if (dl > 0x7fff)
-				dl = 0x7fff;
-			else if (dl < -0x8000)
-				dl = -0x8000;
+		/* what the first channel did not store is silence */
+		if (written == 0 && mixed < count) {
+			memset(&tmpMixBuffer[mixed*2], 0, (count-mixed)*2*sizeof(Sint32));
+		}
+		written = count;
+	}
 
-			*dest++ = dl;
+	/* Music rendered here is clipped and converted with the sounds */
+	if (sysaudio.mix_music) {
+		if (!written) {
+			memset(tmpMixBuffer, 0, count*2*sizeof(Sint32));
+		}
+		sysaudio.mix_music(tmpMixBuffer, count);
+		written = count;
+	}
 
-			if (dr > 0x7fff)
-				dr = 0x7fff;
-			else if (dr < -0x8000)
-				dr = -0x8000;
+	if (!written) {
+		if (mixFormat == MIX_S16ADD)
+			return;
+		memset(tmpMixBuffer, 0, count*2*sizeof(Sint32));
+	}
 
-			*dest++ = dr;
-		}
-	} else {
-		for (i=0; i<srclen>>2; i++) {
-			Sint32 dl, dr;
+	I_WriteMix(tmpMixBuffer, stream, count);
+}
 
-			dl = *source++;
-			dr = *source++;
 
-			if (dl > 0x7fff)
-				dl = 0x7fff;
-			else if (dl < -0x8000)
-				dl = -0x8000;
+//
+// I_BenchMix
+// Mixes one second of sound with more and more channels,
+//  before the audio callback is started.
+// The sample outlasts each callback, so no channel finishes
+//  and I_SoundDone is never reached.
+//
+static void I_BenchMix(void)
+{
+	Uint8 *sample, *stream;
+	int numchannels, chan, i;
+	int frames, done, length;
+	unsigned int start, elapsed, step;
+
+	frames = sysaudio.obtained.samples;
+	step = (65536*11025)/sysaudio.obtained.freq;
+	length = ((frames*step)>>16) + 2;
+
+	sample = Z_Malloc(length, PU_STATIC, NULL);
+	for (i=0; i<length; i++) {
+		sample[i] = (i*73) ^ (i>>3);
+	}
 
-			*dest++ = dl;
+	stream = Z_Malloc(sysaudio.obtained.size, PU_STATIC, NULL);
 
-			if (dr > 0x7fff)
-				dr = 0x7fff;
-			else if (dr < -0x8000)
-				dr = -0x8000;
+	for (numchannels=1; numchannels<=NUM_CHANNELS; numchannels*=2) {
+		start = I_GetTimeUS();
 
-			*dest++ = dr;
+		for (done=0; done<sysaudio.obtained.freq; done+=frames) {
+			for (chan=0; chan<numchannels; chan++) {
+				i_sound_channels[chan].startp = sample;
+				i_sound_channels[chan].length = length;
+				i_sound_channels[chan].position = 0;
+				i_sound_channels[chan].stepremainder = 0;
+				i_sound_channels[chan].step = step;
+				i_sound_channels[chan].leftgain = 64 + chan;
+				i_sound_channels[chan].rightgain = 192 - chan;
+			}
+			memset(stream, 0, sysaudio.obtained.size);
+			I_UpdateSound_SDL(NULL, stream, sysaudio.obtained.size);
 		}
-	}
 
-	/* Conversion if needed */
-	if (sysaudio.convert) {
-		sysaudio.audioCvt.buf = (Uint8 *) tmpMixBuffer2;
-		sysaudio.audioCvt.len = srclen;
-		SDL_ConvertAudio(&sysaudio.audioCvt);
+		elapsed = I_GetTimeUS() - start;
+		printf("I_BenchMix: %2d channels, %7u us per second of sound,"
+			" %6u us per channel\n", numchannels, elapsed,
+			elapsed/numchannels);
+	}
 
-		SDL_MixAudio(stream, sysaudio.audioCvt.buf, len, SDL_MIX_MAXVOLUME);
+	for (chan=0; chan<NUM_CHANNELS; chan++) {
+		i_sound_channels[chan].startp = NULL;
 	}
+
+	Z_Free(stream);
+	Z_Free(sample);
 }
 
 
@@ -281,7 +415,33 @@ int I_InitSound_SDL(void)
     }
 #endif
 
-    if ((sysaudio.obtained.format != AUDIO_S16SYS) || (sysaudio.obtained.channels != 2)) {
+    /* Formats written as they are mixed, SDL_mixer music is 16 bits */
+    mixFormat = MIX_CONVERT;
+    if (sysaudio.obtained.format == AUDIO_S16SYS) {
+        if (sysaudio.obtained.channels == 2) {
+#ifdef ENABLE_SDLMIXER
+            mixFormat = MIX_S16ADD;
+#else
+            mixFormat = MIX_S16;
+#endif
+        }
+#ifndef ENABLE_SDLMIXER
+        else if (sysaudio.obtained.channels == 1) {
+            mixFormat = MIX_S16MONO;
+        }
+#endif
+    }
+#ifndef ENABLE_SDLMIXER
+    else if (sysaudio.obtained.format == AUDIO_U8) {
+        if (sysaudio.obtained.channels == 2) {
+            mixFormat = MIX_U8;
+        } else if (sysaudio.obtained.channels == 1) {
+            mixFormat = MIX_U8MONO;
+        }
+    }
+#endif
+
+    if (mixFormat == MIX_CONVERT) {
         sysaudio.convert = true;
         if (SDL_BuildAudioCVT(&sysaudio.audioCvt, AUDIO_S16SYS, 2, sysaudio.obtained.freq, sysaudio.obtained.format, sysaudio.obtained.channels, sysaudio.obtained.freq) == -1) {
 #ifdef ENABLE_SDLMIXER
@@ -293,11 +453,6 @@ int I_InitSound_SDL(void)
         }
     }
 
-#ifdef ENABLE_SDLMIXER
-    Mix_SetPostMix(I_UpdateSound_SDL, NULL);
-#else
-    SDL_PauseAudio(0);
-#endif
     char deviceName[32];
     if (SDL_AudioDriverName(deviceName, sizeof(deviceName))==NULL) {
         memset(deviceName, 0, sizeof(deviceName));
@@ -313,9 +468,20 @@ int I_InitSound_SDL(void)
     tmpMixBuffLen = sysaudio.obtained.samples * 2 * sizeof(Sint32);
     tmpMixBuffer = Z_Malloc(tmpMixBuffLen, PU_STATIC, 0);
     if (sysaudio.convert) {
-        tmpMixBuffer2 = Z_Malloc(tmpMixBuffLen>>1, PU_STATIC, 0);
+        tmpMixBuffer2 = Z_Malloc((tmpMixBuffLen>>1) * sysaudio.audioCvt.len_mult,
+            PU_STATIC, 0);
+    }
+
+    if (sysaudio.bench_mix) {
+        I_BenchMix();
     }
 
+#ifdef ENABLE_SDLMIXER
+    Mix_SetPostMix(I_UpdateSound_SDL, NULL);
+#else
+    SDL_PauseAudio(0);
+#endif
+
     sysaudio.sdl_available = true;
     return true;
 }
@@ -22,6 +22,7 @@
 
 #include <stdarg.h>
 #include <sys/time.h>
+#include <time.h>
 #include <unistd.h>
 
 #include <SDL.h>
@@ -32,6 +33,7 @@
 
 #include "doomdef.h"
 #include "m_misc.h"
+#include "m_prof.h"
 #include "m_fixed.h"
 #include "i_video.h"
 #include "i_audio.h"
@@ -43,7 +45,7 @@
 
 #include "i_system.h"
 
-sysgame_t	sysgame={DEFAULT_HEAP_SIZE,NULL,false};
+sysgame_t	sysgame={DEFAULT_HEAP_SIZE,NULL,false,false,DEFAULT_COMPOSITE_SIZE,true};
 
 static void I_InitFpu(void);
 
@@ -119,12 +121,75 @@ int  I_GetTime (void)
 }
 
 
+//
+// I_GetTimeVal
+// Time since I_InitTimeVal, for the clocks below.
+// The base is set before any thread runs, and never changes.
+//
+static time_t	basesec;
+
+static void I_GetTimeVal (struct timeval* tv)
+{
+#ifdef CLOCK_MONOTONIC
+    struct timespec	ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    tv->tv_sec = ts.tv_sec;
+    tv->tv_usec = ts.tv_nsec/1000;
+#else
+    gettimeofday (tv, NULL);
+#endif
+    tv->tv_sec -= basesec;
+}
+
+static void I_InitTimeVal (void)
+{
+    struct timeval	tv;
+
+    basesec = 0;
+    I_GetTimeVal (&tv);
+    basesec = tv.tv_sec;
+}
+
+
+//
+// I_GetTimeMS
+//
+int I_GetTimeMS (void)
+{
+#ifdef CLOCK_MONOTONIC
+    struct timeval	tv;
+
+    I_GetTimeVal (&tv);
+    return tv.tv_sec*1000 + tv.tv_usec/1000;
+#else
+    // gettimeofday follows clock changes
+    return SDL_GetTicks();
+#endif
+}
+
+
+//
+// I_GetTimeUS
+// Wraps around, only differences are meaningful.
+//
+unsigned int I_GetTimeUS (void)
+{
+    struct timeval	tv;
+
+    I_GetTimeVal (&tv);
+    return tv.tv_sec*1000000 + tv.tv_usec;
+}
+
+
 
 //
 // I_Init
 //
 void I_Init (void)
 {
+	I_InitTimeVal();
+
 	if (SDL_Init(SDL_INIT_VIDEO|SDL_INIT_JOYSTICK)<0) {
 		fprintf(stderr, "Can not initialize SDL: %s\n", SDL_GetError());
 		exit(1);
@@ -247,6 +312,7 @@ static void I_Shutdown(void)
 //
 void I_Quit (void)
 {
+	M_ProfReport ();
 	D_QuitNetGame ();
 	M_SaveDefaults ();
 	I_Shutdown();
@@ -36,6 +36,12 @@ byte*	I_ZoneBase (int *size);
 // returns current time in tics.
 int I_GetTime (void);
 
+// Returns current time in milliseconds, for timings.
+int I_GetTimeMS (void);
+
+// Returns current time in microseconds, for profiling.
+unsigned int I_GetTimeUS (void);
+
 
 //
 // Called by D_DoomLoop,
@@ -70,6 +76,9 @@ typedef struct {
 	int kb_used;
 	void *zone;
 	boolean cpu060;
+	boolean mmap_wads;
+	int kb_composites;
+	boolean data_cache;
 } sysgame_t;
 
 extern sysgame_t	sysgame;
@@ -77,4 +86,6 @@ extern sysgame_t	sysgame;
 #define DEFAULT_HEAP_SIZE	8192	/* 8MB by default */
 #define MINIMAL_HEAP_SIZE	2500	/* 2.5MB minimum */
 
+#define DEFAULT_COMPOSITE_SIZE	512	/* Multi-patch textures, in KB */
+
 #endif
@@ -59,6 +59,17 @@ static int new_width=0,new_height=0;
 static SDL_Overlay *overlay;
 static int overlay_format=SDL_YUY2_OVERLAY;
 
+/* Pipelined presentation: a presenter thread shows the shadow surface
+   of the previous frame while the game draws the next one in backshadow.
+   videolock serializes SDL video/event calls between both threads. */
+static SDL_Surface *backshadow=NULL;
+static SDL_Thread *presenter=NULL;
+static SDL_sem *present_start, *present_done, *videolock;
+static SDL_Surface *present_surf;
+static SDL_Color present_colors[256];
+static int present_newpalette=0, present_quit=0;
+static int palette_changed=0;
+
 static SDL_GrabMode mouse_grab=SDL_GRAB_OFF;
 static int mouseb=0;
 
@@ -69,13 +80,21 @@ int num_joystick;	/* from doomrc file */
 sysvideo_t sysvideo =
 {
 	SCREENWIDTH, SCREENHEIGHT, 8, SCREENWIDTH,
-	false, false, true, false
+	false, false, true, false,
+	1, false, false, false, false
 };
 
 /*--- Local functions ---*/
 
 static void InitSdlMode(int width, int height, int bpp);
 static int xlatekey(SDLKey keysym);
+static void I_ApplyPalette(SDL_Color *palette);
+static void I_PresentFrame(SDL_Surface *frame);
+static void I_StartPresenter(void);
+static void I_StopPresenter(void);
+
+#define I_LockVideo()	{ if (presenter) SDL_SemWait(videolock); }
+#define I_UnlockVideo()	{ if (presenter) SDL_SemPost(videolock); }
 
 //
 //  Translates the key currently in X_event
@@ -137,6 +156,8 @@ static int xlatekey(SDLKey keysym)
 
 void I_ShutdownGraphics(void)
 {
+	I_StopPresenter();
+
 	if (joystick!=NULL) {
 		if (SDL_JoystickOpened(SDL_JoystickIndex(joystick))) {
 			SDL_JoystickClose(joystick);
@@ -152,13 +173,22 @@ void I_ShutdownGraphics(void)
 		SDL_FreeSurface(shadow);
 		shadow=NULL;
 	}
+	if (backshadow) {
+		SDL_FreeSurface(backshadow);
+		backshadow=NULL;
+	}
 }
 
 void I_StartTic(void)
 {
 	SDL_Event	event;
 	event_t		doom_event;
-	
+
+	/* Do not wait for the presenter, events will be read next time */
+	if (presenter && SDL_SemTryWait(videolock)) {
+		return;
+	}
+
 	while (SDL_PollEvent(&event)) {
 		switch(event.type) {
 			case SDL_KEYDOWN:
@@ -296,23 +326,22 @@ void I_StartTic(void)
 				new_height = event.resize.h;
 				break;
 			case SDL_QUIT:
+				I_UnlockVideo();
 				I_Quit();
 				break;
 		}
 	}
+
+	I_UnlockVideo();
 }
 
 //
-// I_FinishUpdate
+// I_PresentFrame
+// Shows a finished frame.
 //
-void I_FinishUpdate (void)
+static void I_PresentFrame(SDL_Surface *frame)
 {
-	static int frame_start_tick = 0, frame_end_tick = 0;
-	int cur_ticks, cur_frame_duration;
-
-	// draws little dots on the bottom of the screen
-	if (devparm)
-		ST_DrawFps(last_fps);
+	int cur_ticks;
 
 	if (sysvideo.overlay) {
 		SDL_Rect ov_rect;
@@ -340,19 +369,19 @@ void I_FinishUpdate (void)
                 switch (overlay_format)
                 {
                     case SDL_YUY2_OVERLAY:
-                         I_RGB8toYUY2(shadow, overlay);
+                         I_RGB8toYUY2(frame, overlay);
                          break;
                     case SDL_YV12_OVERLAY:
-                         I_RGB8toYV12(shadow, overlay);
+                         I_RGB8toYV12(frame, overlay);
                          break;
                     case SDL_UYVY_OVERLAY:
-                         I_RGB8toUYVY(shadow, overlay);
+                         I_RGB8toUYVY(frame, overlay);
                          break;
                     case SDL_YVYU_OVERLAY:
-                         I_RGB8toYVYU(shadow, overlay);
+                         I_RGB8toYVYU(frame, overlay);
                          break;
                     case SDL_IYUV_OVERLAY:
-                         I_RGB8toIYUV(shadow, overlay);
+                         I_RGB8toIYUV(frame, overlay);
                          break;
                 }
 
@@ -362,35 +391,40 @@ void I_FinishUpdate (void)
 			SDL_UnlockSurface(screen);
 		}
 
-		if (shadow) {
-			SDL_BlitSurface(shadow, NULL, screen, &update_area);
+		if (frame) {
+			if (screen->format->BytesPerPixel==4) {
+				I_RGB8toRGB32(frame, screen, &update_area);
+			} else {
+				SDL_BlitSurface(frame, NULL, screen, &update_area);
+			}
 		}
 		SDL_Flip(screen);
 
 		if (SDL_MUSTLOCK(screen)) {
 			SDL_LockSurface(screen);
 		}
-
-		if (screen->flags & SDL_DOUBLEBUF) {
-			if (!shadow) {
-				screens[0] = screen->pixels;
-				screens[0] += update_area.y * screen->pitch;
-				screens[0] += update_area.x;
-
-				R_InitBuffer (scaledviewwidth, viewheight);
-				AM_SetViewSize();
-			}
-		}
 	}
 
 	fps++;
-	frame_end_tick = cur_ticks = SDL_GetTicks();
+	cur_ticks = SDL_GetTicks();
 	if (cur_ticks-frame_tick>1000) {
 		frame_tick=cur_ticks;
 		last_fps=fps;
 		fps=0;
 	}
+}
 
+//
+// I_LimitFrame
+// Waits after a frame if we are a fast machine. The presenter
+//  calls it without videolock, so that input is still read.
+//
+static void I_LimitFrame(void)
+{
+	static int frame_start_tick = 0;
+	int frame_end_tick, cur_frame_duration;
+
+	frame_end_tick = SDL_GetTicks();
 	cur_frame_duration = frame_end_tick - frame_start_tick;
 	if (cur_frame_duration < FRAME_DURATION) {
 		int wait_duration = FRAME_DURATION - cur_frame_duration - 1;
@@ -399,6 +433,129 @@ void I_FinishUpdate (void)
 		}
 	}
 
+	frame_start_tick = frame_end_tick;
+}
+
+//
+// I_PresentThread
+// Presents each frame handed over by I_FinishUpdate.
+//
+static int I_PresentThread(void *data)
+{
+	for (;;) {
+		SDL_SemWait(present_start);
+		if (present_quit) {
+			break;
+		}
+
+		SDL_SemWait(videolock);
+		if (present_newpalette) {
+			I_ApplyPalette(present_colors);
+			present_newpalette = 0;
+		}
+		I_PresentFrame(present_surf);
+		SDL_SemPost(videolock);
+
+		I_LimitFrame();
+
+		SDL_SemPost(present_done);
+	}
+
+	return 0;
+}
+
+static void I_StartPresenter(void)
+{
+	present_start = SDL_CreateSemaphore(0);
+	present_done = SDL_CreateSemaphore(1);
+	videolock = SDL_CreateSemaphore(1);
+
+	if (present_start && present_done && videolock) {
+		present_quit = 0;
+		presenter = SDL_CreateThread(I_PresentThread, NULL);
+	}
+
+	if (!presenter) {
+		fprintf(stderr, "Can not start presenter thread: %s\n", SDL_GetError());
+		sysvideo.pipeline = false;
+	}
+}
+
+static void I_StopPresenter(void)
+{
+	if (!presenter) {
+		return;
+	}
+
+	SDL_SemWait(present_done);
+	present_quit = 1;
+	SDL_SemPost(present_start);
+	SDL_WaitThread(presenter, NULL);
+	presenter = NULL;
+
+	SDL_DestroySemaphore(present_start);
+	SDL_DestroySemaphore(present_done);
+	SDL_DestroySemaphore(videolock);
+}
+
+//
+// I_FinishUpdate
+//
+void I_FinishUpdate (void)
+{
+	// draws little dots on the bottom of the screen
+	if (devparm)
+		ST_DrawFps(last_fps);
+
+	if (presenter) {
+		SDL_Surface *frame;
+
+		/* The previous frame is on screen, its surface is free again */
+		SDL_SemWait(present_done);
+
+		if (palette_changed) {
+			memcpy(present_colors, colors, sizeof(colors));
+			present_newpalette = 1;
+			palette_changed = 0;
+		}
+
+		frame = shadow;
+		shadow = backshadow;
+		backshadow = frame;
+
+		present_surf = frame;
+		SDL_SemPost(present_start);
+
+		screens[0] = shadow->pixels;
+		R_InitBuffer (scaledviewwidth, viewheight);
+		AM_SetViewSize();
+
+		if (new_width && new_height) {
+			SDL_SemWait(present_done);
+			if (!sysvideo.overlay && SDL_MUSTLOCK(screen)) {
+				SDL_UnlockSurface(screen);
+			}
+			InitSdlMode(new_width, new_height, sysvideo.bpp);
+			new_width = new_height = 0;
+			SDL_SemPost(present_done);
+		}
+		return;
+	}
+
+	I_PresentFrame(shadow);
+	I_LimitFrame();
+
+	if (!sysvideo.overlay && (screen->flags & SDL_DOUBLEBUF)) {
+		if (!shadow) {
+			screens[0] = screen->pixels;
+			screens[0] += update_area.y * screen->pitch;
+			screens[0] += update_area.x;
+
+			R_InitBuffer (scaledviewwidth, viewheight);
+			AM_SetViewSize();
+		}
+	}
+
 	if (new_width && new_height) {
 		if (!sysvideo.overlay && SDL_MUSTLOCK(screen)) {
 			SDL_UnlockSurface(screen);
@@ -407,8 +564,6 @@ void I_FinishUpdate (void)
 		InitSdlMode(new_width, new_height, sysvideo.bpp);
 		new_width = new_height = 0;
 	}
-
-	frame_start_tick = frame_end_tick;
 }
 
 //
@@ -436,10 +591,12 @@ void I_GrabMouse(void)
 	if (screen->flags & SDL_FULLSCREEN)
 		return;
 		
+	I_LockVideo();
 	SDL_WM_GrabInput(mouse_grab);
 	if (mouse_grab == SDL_GRAB_ON) {
 		SDL_ShowCursor(SDL_DISABLE);
 	}
+	I_UnlockVideo();
 }
 
 void I_UngrabMouse(void)
@@ -447,8 +604,10 @@ void I_UngrabMouse(void)
 	if (screen->flags & SDL_FULLSCREEN)
 		return;
 		
+	I_LockVideo();
 	SDL_WM_GrabInput(SDL_GRAB_OFF);
 	SDL_ShowCursor(SDL_ENABLE);
+	I_UnlockVideo();
 }
 
 //
@@ -466,12 +625,27 @@ void I_SetPalette (byte* palette)
 		}
 	}
 
+	/* Applied by the presenter, with the next frame */
+	if (presenter) {
+		palette_changed = 1;
+		return;
+	}
+
+	I_ApplyPalette(colors);
+}
+
+static void I_ApplyPalette(SDL_Color *palette)
+{
 	if (shadow)
-		SDL_SetColors(shadow, colors, 0,256);
+		SDL_SetColors(shadow, palette, 0,256);
+	if (backshadow)
+		SDL_SetColors(backshadow, palette, 0,256);
 	if (sysvideo.overlay) {
-		I_Pal2Yuv(colors);
+		I_Pal2Yuv(palette);
+	} else if (screen->format->BytesPerPixel==4) {
+		I_Pal2Rgb32(palette, screen->format);
 	}
-	SDL_SetPalette(screen, SDL_LOGPAL|SDL_PHYSPAL, colors, 0, 256);
+	SDL_SetPalette(screen, SDL_LOGPAL|SDL_PHYSPAL, palette, 0, 256);
 }
 
 static void InitSdlMode(int width, int height, int bpp)
@@ -540,11 +714,19 @@ static void InitSdlMode(int width, int height, int bpp)
 			    I_Error("Can not create shadow surface: %s\n", SDL_GetError());
 
 		 	output_surf = shadow;
+
+			if (sysvideo.pipeline) {
+				if (!backshadow)
+					backshadow = SDL_CreateRGBSurface(SDL_SWSURFACE,SCREENWIDTH,SCREENHEIGHT,8,0,0,0,0);
+				if (!backshadow)
+				    I_Error("Can not create shadow surface: %s\n", SDL_GetError());
+			}
 		}
 	}
 
 	if (!sysvideo.overlay) {
-		if (screen->format->BitsPerPixel==8) {
+		/* The presenter needs a shadow surface even in 8 bits */
+		if ((screen->format->BitsPerPixel==8) && !sysvideo.pipeline) {
 			if (shadow) {
 				SDL_FreeSurface(shadow);
 				shadow=NULL;
@@ -555,6 +737,13 @@ static void InitSdlMode(int width, int height, int bpp)
 			if (!shadow)
 			    I_Error("Can not create shadow surface: %s\n", SDL_GetError());
 
+			if (sysvideo.pipeline) {
+				if (!backshadow)
+					backshadow = SDL_CreateRGBSurface(SDL_SWSURFACE,shadow->w,shadow->h,8,0,0,0,0);
+				if (!backshadow)
+				    I_Error("Can not create shadow surface: %s\n", SDL_GetError());
+			}
+
 			output_surf = shadow;
 		}
 
@@ -606,7 +795,7 @@ static void InitSdlMode(int width, int height, int bpp)
 	V_Init();
 	R_InitPlanes();
 	R_InitSpritesData();
-	ST_SetNumRefresh(screen->flags & SDL_DOUBLEBUF ? 2 : 1);
+	ST_SetNumRefresh((screen->flags & SDL_DOUBLEBUF) || sysvideo.pipeline ? 2 : 1);
 	ST_Start();
 	AM_SetViewSize();
 	R_ExecuteSetViewSize();
@@ -614,6 +803,96 @@ static void InitSdlMode(int width, int height, int bpp)
 	R_DrawViewBorder();
 }
 
+//
+// I_BenchConvert
+// Times the conversions of the 8 bits screen, used by I_PresentFrame.
+//
+static void I_BenchConvert(void)
+{
+	static const struct {
+		const char *name;
+		Uint32 format;
+		void (*convert)(SDL_Surface *s, SDL_Overlay *o);
+	} kernels[5] = {
+		{"YUY2", SDL_YUY2_OVERLAY, I_RGB8toYUY2},
+		{"YV12", SDL_YV12_OVERLAY, I_RGB8toYV12},
+		{"UYVY", SDL_UYVY_OVERLAY, I_RGB8toUYVY},
+		{"YVYU", SDL_YVYU_OVERLAY, I_RGB8toYVYU},
+		{"IYUV", SDL_IYUV_OVERLAY, I_RGB8toIYUV}
+	};
+	const int frames = 200;
+	SDL_Surface *src, *dst;
+	SDL_Overlay *ov;
+	SDL_Rect area;
+	Uint8 *p;
+	double mpixels;
+	int i, x, y, start, duration;
+
+	src = SDL_CreateRGBSurface(SDL_SWSURFACE,SCREENWIDTH,SCREENHEIGHT,8,0,0,0,0);
+	dst = SDL_CreateRGBSurface(SDL_SWSURFACE,SCREENWIDTH,SCREENHEIGHT,32,
+		0x00ff0000,0x0000ff00,0x000000ff,0);
+	if (!src || !dst) {
+		fprintf(stderr, "I_BenchConvert: %s\n", SDL_GetError());
+		if (src)
+			SDL_FreeSurface(src);
+		if (dst)
+			SDL_FreeSurface(dst);
+		return;
+	}
+
+	for (y=0; y<src->h; y++) {
+		p = ((Uint8 *) src->pixels) + src->pitch*y;
+		for (x=0; x<src->w; x++) {
+			*p++ = (x*7 + y*13) & 255;
+		}
+	}
+	SDL_SetColors(src, colors, 0, 256);
+	I_Pal2Yuv(colors);
+	I_Pal2Rgb32(colors, dst->format);
+
+	mpixels = ((double) SCREENWIDTH * SCREENHEIGHT * frames) / 1000000.0;
+	printf("I_BenchConvert: %dx%d, %d frames\n", SCREENWIDTH, SCREENHEIGHT, frames);
+
+	for (i=0; i<5; i++) {
+		ov = SDL_CreateYUVOverlay(SCREENWIDTH, SCREENHEIGHT, kernels[i].format, screen);
+		if (!ov) {
+			printf(" %s: no overlay\n", kernels[i].name);
+			continue;
+		}
+		start = I_GetTimeMS();
+		for (x=0; x<frames; x++) {
+			kernels[i].convert(src, ov);
+		}
+		duration = I_GetTimeMS() - start;
+		printf(" %s: %.3f ms/Mpixel\n", kernels[i].name, duration / mpixels);
+		SDL_FreeYUVOverlay(ov);
+	}
+
+	area.x = area.y = 0;
+	area.w = SCREENWIDTH;
+	area.h = SCREENHEIGHT;
+
+	start = I_GetTimeMS();
+	for (x=0; x<frames; x++) {
+		I_RGB8toRGB32(src, dst, &area);
+	}
+	duration = I_GetTimeMS() - start;
+	printf(" XRGB8888: %.3f ms/Mpixel\n", duration / mpixels);
+
+	start = I_GetTimeMS();
+	for (x=0; x<frames; x++) {
+		SDL_BlitSurface(src, NULL, dst, &area);
+	}
+	duration = I_GetTimeMS() - start;
+	printf(" XRGB8888 (SDL_BlitSurface): %.3f ms/Mpixel\n", duration / mpixels);
+
+	SDL_FreeSurface(dst);
+	SDL_FreeSurface(src);
+
+	/* Tables back to the current screen */
+	I_ApplyPalette(colors);
+}
+
 void I_InitGraphics(void)
 {
 	static int firsttime=1;
@@ -631,10 +910,16 @@ void I_InitGraphics(void)
 	if (sysvideo.overlay && (sysvideo.bpp==8))
 		sysvideo.bpp = 32;
 
+	if (sysvideo.pipeline)
+		I_StartPresenter();
+
 	InitSdlMode(sysvideo.width, sysvideo.height, sysvideo.bpp);
 
 	SDL_WM_SetCaption(PACKAGE_STRING, PACKAGE_NAME);
 
+	if (sysvideo.bench_convert)
+		I_BenchConvert();
+
 	/* Joystick stuff */
 	joystick = SDL_JoystickOpen(num_joystick);
 	if (joystick==NULL) {
@@ -49,6 +49,11 @@ typedef struct {
 	int resize;
 	int textured_spans;
 	int overlay;
+	int render_threads;
+	int pipeline;
+	int bench_convert;
+	int quad_columns;
+	int pvs;
 } sysvideo_t;
 
 extern sysvideo_t sysvideo;
@@ -0,0 +1,220 @@
+// Emacs style mode select   -*- C++ -*- 
+//-----------------------------------------------------------------------------
+//
+// Copyright (C) 1993-1996 by id Software, Inc.
+//
+// This source is available for distribution and/or modification
+// only under the terms of the DOOM Source Code License as
+// published by id Software. All rights reserved.
+//
+// The source is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// FITNESS FOR A PARTICULAR PURPOSE. See the DOOM Source Code License
+// for more details.
+//
+// DESCRIPTION:
+//	Frame profiler.
+//	Phases are timed in microseconds and summed over the frame,
+//	 a frame going from one M_ProfFrame call to the next one.
+//	The frame times are kept in memory for the final percentiles,
+//	 outside of the zone so they survive level changes.
+//
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "doomstat.h"
+#include "i_system.h"
+
+#include "m_prof.h"
+
+
+boolean			profiling = false;
+
+static FILE*		csvfile = NULL;
+
+static unsigned int	phasestart[NUMPROFPHASES];
+static unsigned int	phasetime[NUMPROFPHASES];
+static double		phasetotal[NUMPROFPHASES];
+
+static unsigned int	framestart;
+static unsigned int*	frametimes = NULL;
+static int		numframes;
+static int		maxframes;
+
+static const char*	phasenames[NUMPROFPHASES] =
+{
+    "bsp", "planes", "masked", "ticker", "present", "sound", "wipe"
+};
+
+
+//
+// M_ProfInit
+//
+void M_ProfInit (char* csvname)
+{
+    int		i;
+
+    profiling = true;
+
+    if (!csvname || csvfile)
+	return;
+
+    csvfile = fopen (csvname, "w");
+    if (!csvfile)
+    {
+	printf ("M_ProfInit: can not create %s\n", csvname);
+	return;
+    }
+
+    fprintf (csvfile, "frame,gametic,frame_us");
+    for (i=0 ; i<NUMPROFPHASES ; i++)
+	fprintf (csvfile, ",%s_us", phasenames[i]);
+    fprintf (csvfile, "\n");
+}
+
+
+//
+// M_ProfBegin
+//
+void M_ProfBegin (profphase_t phase)
+{
+    if (profiling)
+	phasestart[phase] = I_GetTimeUS ();
+}
+
+
+//
+// M_ProfEnd
+//
+void M_ProfEnd (profphase_t phase)
+{
+    if (profiling)
+	phasetime[phase] += I_GetTimeUS () - phasestart[phase];
+}
+
+
+//
+// M_ProfFrame
+//
+void M_ProfFrame (void)
+{
+    unsigned int	now;
+    unsigned int	frametime;
+    int			i;
+
+    if (!profiling)
+	return;
+
+    now = I_GetTimeUS ();
+
+    // First call only starts the first frame.
+    if (maxframes)
+    {
+	frametime = now - framestart;
+
+	if (numframes == maxframes)
+	{
+	    maxframes *= 2;
+	    frametimes = realloc (frametimes, maxframes*sizeof(*frametimes));
+	    if (!frametimes)
+		I_Error ("M_ProfFrame: no memory for %i frames", maxframes);
+	}
+	frametimes[numframes++] = frametime;
+
+	if (csvfile)
+	    fprintf (csvfile, "%i,%i,%u", numframes, gametic, frametime);
+
+	for (i=0 ; i<NUMPROFPHASES ; i++)
+	{
+	    if (csvfile)
+		fprintf (csvfile, ",%u", phasetime[i]);
+	    phasetotal[i] += phasetime[i];
+	}
+
+	if (csvfile)
+	    fprintf (csvfile, "\n");
+    }
+    else
+    {
+	maxframes = 1024;
+	frametimes = malloc (maxframes*sizeof(*frametimes));
+	if (!frametimes)
+	    I_Error ("M_ProfFrame: no memory for %i frames", maxframes);
+    }
+
+    for (i=0 ; i<NUMPROFPHASES ; i++)
+	phasetime[i] = 0;
+
+    framestart = now;
+}
+
+
+//
+// M_CompareFrames
+// For qsort.
+//
+static int M_CompareFrames (const void* a, const void* b)
+{
+    unsigned int	ta = *(const unsigned int *) a;
+    unsigned int	tb = *(const unsigned int *) b;
+
+    return (ta > tb) - (ta < tb);
+}
+
+
+//
+// M_Percentile
+// Nearest rank, the frame times being sorted.
+//
+static double M_Percentile (int percent)
+{
+    int		rank;
+
+    rank = (percent*numframes + 99) / 100;
+    if (rank < 1)
+	rank = 1;
+
+    return frametimes[rank-1] / 1000.0;
+}
+
+
+//
+// M_ProfReport
+//
+void M_ProfReport (void)
+{
+    double	total;
+    int		i;
+
+    if (!profiling)
+	return;
+    profiling = false;
+
+    if (csvfile)
+    {
+	fclose (csvfile);
+	csvfile = NULL;
+    }
+
+    if (!numframes)
+	return;
+
+    total = 0;
+    for (i=0 ; i<numframes ; i++)
+	total += frametimes[i];
+
+    qsort (frametimes, numframes, sizeof(*frametimes), M_CompareFrames);
+
+    printf ("M_ProfReport: %i frames, frame time in ms: mean %.3f,"
+	    " p50 %.3f, p95 %.3f, p99 %.3f, max %.3f\n",
+	    numframes, total / numframes / 1000.0,
+	    M_Percentile (50), M_Percentile (95), M_Percentile (99),
+	    frametimes[numframes-1] / 1000.0);
+
+    printf ("M_ProfReport: mean ms per frame:");
+    for (i=0 ; i<NUMPROFPHASES ; i++)
+	printf (" %s %.3f", phasenames[i], phasetotal[i] / numframes / 1000.0);
+    printf ("\n");
+}
@@ -0,0 +1,57 @@
+// Emacs style mode select   -*- C++ -*- 
+//-----------------------------------------------------------------------------
+//
+// Copyright (C) 1993-1996 by id Software, Inc.
+//
+// This source is available for distribution and/or modification
+// only under the terms of the DOOM Source Code License as
+// published by id Software. All rights reserved.
+//
+// The source is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// FITNESS FOR A PARTICULAR PURPOSE. See the DOOM Source Code License
+// for more details.
+//
+// DESCRIPTION:
+//	Frame profiler, timing the main phases of every frame.
+//    
+//-----------------------------------------------------------------------------
+
+#ifndef __M_PROF__
+#define __M_PROF__
+
+
+#include "doomtype.h"
+
+
+typedef enum
+{
+    prof_bsp,		// R_RenderBSPNode
+    prof_planes,	// R_DrawPlanes, and queued walls with render threads
+    prof_masked,	// R_DrawMasked
+    prof_ticker,	// G_Ticker, P_Ticker included
+    prof_present,	// I_FinishUpdate
+    prof_sound,		// S_UpdateSounds, I_UpdateMusic
+    prof_wipe,		// Screen wipe, its I_FinishUpdate included
+    NUMPROFPHASES
+
+} profphase_t;
+
+
+extern boolean	profiling;
+
+// Starts collecting frame times,
+//  also written to csvname if not NULL.
+void M_ProfInit (char* csvname);
+
+void M_ProfBegin (profphase_t phase);
+void M_ProfEnd (profphase_t phase);
+
+// Called by D_DoomLoop, once per frame.
+void M_ProfFrame (void);
+
+// Prints mean, percentiles and maximum of the frame times.
+void M_ProfReport (void);
+
+
+#endif
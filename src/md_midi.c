@@ -124,7 +124,7 @@ char* fd_fgets(MD_MFBuf* fd, char* buf, uint32_t buflen) {
 }
 
 static inline uint32_t fd_read(MD_MFBuf* fd, uint8_t* buf, uint32_t len) {
-    memcpy(buf, fd->_data, len);
+    memcpy(buf, &fd->_data[fd->_pos], len);
     fd->_pos += len;
     return len;
 }
@@ -152,88 +152,14 @@ static inline uint32_t fd_readVarLen(MD_MFBuf* fd)
 
 
 // ---------------------------------------------------------------------------------------------
-// midi file helpers
-// ---------------------------------------------------------------------------------------------
-
-static inline uint32_t mf_getTickTime(MD_MIDIFile* mf) { return (mf->_tickTime); }
-static inline uint16_t mf_getTempo(MD_MIDIFile* mf) { return(mf->_tempo); }
-static inline int16_t  mf_getTempoAdjust(MD_MIDIFile* mf) { return(mf->_tempoDelta); }
-static inline uint16_t mf_getTicksPerQuarterNote(MD_MIDIFile* mf) { return(mf->_ticksPerQuarterNote); }
-static inline uint16_t mf_getTimeSignature(MD_MIDIFile* mf) { return((mf->_timeSignature[0]<<8) + mf->_timeSignature[1]); }
-
-uint16_t mf_tickClock(MD_MIDIFile* mf) {
-    // check if enough time has passed for a MIDI tick and work out how many!
-    uint16_t  ticks = 0;
-    uint32_t elapsedTime = mf->_lastTickError + micros() - mf->_lastTickCheckTime;
-    if (elapsedTime >= mf->_tickTime) {
-        ticks = elapsedTime/mf->_tickTime;
-        mf->_lastTickError = elapsedTime - (mf->_tickTime * ticks);
-        mf->_lastTickCheckTime = micros();    // save for next round of checks
-    }
-    return(ticks);
-}
-
-static void mf_calcTickTime(MD_MIDIFile* mf) {
-    // 1 tick = microseconds per beat / ticks per Q note
-    // The variable "microseconds per beat" is specified by a MIDI event carrying 
-    // the set tempo meta message. If it is not specified then it is 500,000 microseconds 
-    // by default, which is equivalent to 120 beats per minute. 
-    // If the MIDI time division is 60 ticks per beat and if the microseconds per beat 
-    // is 500,000, then 1 tick = 500,000 / 60 = 8333.33 microseconds.
-    if ((mf->_tempo + mf->_tempoDelta != 0) && mf->_ticksPerQuarterNote != 0 && mf->_timeSignature[1] != 0) {
-        mf->_tickTime = (60 * 1000000L) / (mf->_tempo + mf->_tempoDelta); // microseconds per beat
-        mf->_tickTime /= mf->_ticksPerQuarterNote;
-    }
-    dbg("_tempo               = %d", mf->_tempo);
-    dbg("_tempoDelta          = %d", mf->_tempoDelta);
-    dbg("_ticksPerQuarterNote = %d", mf->_ticksPerQuarterNote);
-    dbg("_timeSignature       = %d", mf->_timeSignature);
-    dbg("_tickTime            = %d", mf->_tickTime);
-}
-
-static void mf_setMicrosecondPerQuarterNote(MD_MIDIFile* mf, uint32_t m) {
-    // This is the value given in the META message setting tempo
-    // work out the tempo from the delta by reversing the calcs in
-    // calctickTime - m is already per quarter note
-    mf->_tempo = (60 * 1000000L) / m;
-    mf_calcTickTime(mf);
-}
-static void mf_setTempo(MD_MIDIFile* mf, uint16_t t) {
-    if ((mf->_tempoDelta + t) > 0) mf->_tempo = t;
-    mf_calcTickTime(mf);
-}
-static void mf_setTempoAdjust(MD_MIDIFile* mf, int16_t t) {
-    if ((t + mf->_tempo) > 0) mf->_tempoDelta = t;
-    mf_calcTickTime(mf);
-}
-static void mf_setTicksPerQuarterNote(MD_MIDIFile* mf, uint16_t ticks) {
-    mf->_ticksPerQuarterNote = ticks;
-    mf_calcTickTime(mf);
-}
-static void mf_setTimeSignature(MD_MIDIFile* mf, uint8_t n, uint8_t d) {
-    mf->_timeSignature[0] = n;
-    mf->_timeSignature[1] = d;
-    mf_calcTickTime(mf);
-}
-
-static void mf_synchTracks(MD_MIDIFile* mf)
-{
-    for (uint16_t i = 0; i < mf->_trackCount; i++)
-        mf->_track[i]._elapsedTicks = 0;
-    mf->_lastTickCheckTime = micros();
-    mf->_lastTickError = 0;
-}
-
-
-// ---------------------------------------------------------------------------------------------
-// midi track helpers
+// midi track decoding
 // ---------------------------------------------------------------------------------------------
 
 static void mt_restart(MD_MFTrack* mt)
 {
   mt->_currOffset = 0;
   mt->_endOfTrack = false;
-  mt->_elapsedTicks = 0;
+  mt->_nextTick = 0;
 }
 
 static void mt_reset(MD_MFTrack* mt)
@@ -242,12 +168,28 @@ static void mt_reset(MD_MFTrack* mt)
     mt->_startOffset = 0;   // start of the track in bytes from start of file
     mt_restart(mt);
     mt->_trackId = 255;
+    mt->_mev.size = 0;
 }
 
+static void mt_readDeltaTime(MD_MIDIFile* mf, MD_MFTrack* mt)
+{
+    // track_event = <time:v> + [<midi_event> | <meta_event> | <sysex_event>]
+    // catch end of track when there is no META event
+    if (mt->_endOfTrack || (mt->_currOffset >= mt->_length)) {
+        mt->_endOfTrack = true;
+        return;
+    }
+    fd_seekSet(&mf->_fd, mt->_startOffset+mt->_currOffset);
+    mt->_nextTick += fd_readVarLen(&mf->_fd);
+    mt->_currOffset = fd_pos(&mf->_fd) - mt->_startOffset;
+}
 
-//static MD_sysex_event mt_temp_sev;
-void mt_parseEvent(MD_MIDIFile* mf, MD_MFTrack* mt) {
+// Decodes the event at the track position into ev. Sysex and meta events
+// only keep where they are, they are read again when played. Returns false
+// when the track has no event there.
+static bool mt_decodeEvent(MD_MIDIFile* mf, MD_MFTrack* mt, MD_event* ev, uint32_t* usPerQuarterNote) {
     uint32_t mLen;
+    fd_seekSet(&mf->_fd, mt->_startOffset+mt->_currOffset);
     uint8_t eType = fd_readByte(&mf->_fd);
     switch (eType)
     {
@@ -262,15 +204,10 @@ void mt_parseEvent(MD_MIDIFile* mf, MD_MFTrack* mt) {
             mt->_mev.size = 3;
             mt->_mev.data[0] = eType;
             mt->_mev.channel = mt->_mev.data[0] & 0xf;  // mask off the channel
-            //mt->_mev.data[0] = mt->_mev.data[0] & 0xf0; // just the command byte
             mt->_mev.data[1] = fd_readByte(&mf->_fd);
             mt->_mev.data[2] = fd_readByte(&mf->_fd);
-            #if DUMP_DATA
-                DUMP("[MID2] Ch: %d Data: %02x %02x %02x", mt->_mev.channel, mt->_mev.data[0], mt->_mev.data[1], mt->_mev.data[2]);
-            #else
-                if (mf->_midiHandler != null)
-                    (mf->_midiHandler)(&mt->_mev);
-            #endif
+            ev->type = MD_EVENT_MIDI;
+            ev->mev = mt->_mev;
         }
         break;
 
@@ -279,15 +216,9 @@ void mt_parseEvent(MD_MIDIFile* mf, MD_MFTrack* mt) {
             mt->_mev.size = 2;
             mt->_mev.data[0] = eType;
             mt->_mev.channel = mt->_mev.data[0] & 0xf;  // mask off the channel
-            //mt->_mev.data[0] = mt->_mev.data[0] & 0xf0; // just the command byte
             mt->_mev.data[1] = fd_readByte(&mf->_fd);
-
-            #if DUMP_DATA
-                DUMP("[MID1] Ch: %d Data: %02x %02x", mt->_mev.channel, mt->_mev.data[0], mt->_mev.data[1]);
-            #else
-                if (mf->_midiHandler != null)
-                    (mf->_midiHandler)(&mt->_mev);
-            #endif
+            ev->type = MD_EVENT_MIDI;
+            ev->mev = mt->_mev;
         }
         break;
 
@@ -296,25 +227,19 @@ void mt_parseEvent(MD_MIDIFile* mf, MD_MFTrack* mt) {
             // If the first (status) byte is less than 128 (0x80), this implies that MIDI 
             // running status is in effect, and that this byte is actually the first data byte 
             // (the status carrying over from the previous MIDI event). 
-            // This can only be the case if the immediately previous event was also a MIDI event, 
-            // ie SysEx and Meta events clear running status. This means that the _mev structure 
-            // should contain the info from the previous message in the structure's channel member 
-            // and data[0] (for the MIDI command). 
             // Hence start saving the data at byte data[1] with the byte we have just read (eType) 
             // and use the size member to determine how large the message is (ie, same as before).
+            if (mt->_mev.size == 0) {
+                // no previous message to carry on
+                mt->_endOfTrack = true;
+                DUMP("[RUN ON 0x%02x] Track aborted", eType);
+                return false;
+            }
             mt->_mev.data[1] = eType;
             for (uint8_t i = 2; i < mt->_mev.size && i < 4; i++)
                 mt->_mev.data[i] = fd_readByte(&mf->_fd);  // next byte
-
-            #if DUMP_DATA
-                DUMP("[MID+] Ch: %d Data: ", mt->_mev.channel);
-                for (uint8_t i = 0; i<mt->_mev.size; i++)
-                    DUMP(" %02x", mt->_mev.data[i]);
-            #else
-                if (mf->_midiHandler != null) {
-                    (mf->_midiHandler)(&mt->_mev);
-                }
-            #endif
+            ev->type = MD_EVENT_MIDI;
+            ev->mev = mt->_mev;
         }
         break;
 
@@ -322,38 +247,25 @@ void mt_parseEvent(MD_MIDIFile* mf, MD_MFTrack* mt) {
         case 0xf0:  // sysex_event = 0xF0 + <len:1> + <data_bytes> + 0xF7 
         case 0xf7:  // sysex_event = 0xF7 + <len:1> + <data_bytes> + 0xF7 
         {
-            // collect all the bytes until the 0xf7 - boundaries are included in the message
-            uint16_t index = 0;
-            mf->_sev.track = mt->_trackId;
-            mf->_sev.size = fd_readVarLen(&mf->_fd);
-            if (eType==0xF0) {
-                mf->_sev.data[index++] = eType;
-                mf->_sev.size++;
-            }
-
-            // The length parameter includes the 0xF7 but not the start boundary.
-            // However, it may be bigger than our buffer will allow us to store.
-            if ((mf->_sysexHandler == null) || (mf->_sev.size > ARRAY_SIZE(mf->_sev.data))) {
-                fd_seekCur(&mf->_fd, mf->_sev.size - index);
-            } else {
-                fd_read(&mf->_fd, &mf->_sev.data[index], mf->_sev.size - index);
-                (mf->_sysexHandler)(&mf->_sev);
-            }
+            ev->type = MD_EVENT_SYSEX;
+            ev->mev.track = mt->_trackId;
+            ev->offset = fd_pos(&mf->_fd) - 1;
+            mLen = fd_readVarLen(&mf->_fd);
+            fd_seekCur(&mf->_fd, mLen);
         }
         break;
 
         // ---------------------------- META
         case 0xff:  // meta_event = 0xFF + <meta_type:1> + <length:v> + <event_data_bytes>
         {
+            ev->type = MD_EVENT_META;
+            ev->mev.track = mt->_trackId;
+            ev->offset = fd_pos(&mf->_fd) - 1;
             eType = fd_readByte(&mf->_fd);
             mLen =  fd_readVarLen(&mf->_fd);
             uint32_t pos = fd_pos(&mf->_fd);
             DUMP("[META] Type: %02x Len %d", eType, mLen);
 
-            mf->_mev.track = mt->_trackId;
-            mf->_mev.size = mLen;
-            mf->_mev.type = eType;
-
             switch (eType)
             {
                 case 0x2f:  // End of track
@@ -363,155 +275,21 @@ void mt_parseEvent(MD_MIDIFile* mf, MD_MFTrack* mt) {
                 }
                 break;
 
-                case 0x51:  // set Tempo - really the microseconds per tick
+                case 0x51:  // set Tempo - microseconds per quarter note, from the next event on
                 {
                     uint32_t value = fd_readMultiByte(&mf->_fd, MB_TRYTE);
-                    mf_setMicrosecondPerQuarterNote(mf, value);
-                    mf->_mev.data[0] = (value >> 16) & 0xFF;
-                    mf->_mev.data[1] = (value >> 8) & 0xFF;
-                    mf->_mev.data[2] = value & 0xFF;
-                    DUMP("SET TEMPO to %d us/tick or %d bpm", mf_getTickTime(mf), mf_getTempo(mf));
+                    if (value != 0)
+                        *usPerQuarterNote = value;
+                    DUMP("SET TEMPO to %d us/quarter note", value);
                 }
                 break;
 
                 case 0x58:  // time signature
                 {
-                    uint8_t n = fd_readByte(&mf->_fd);
-                    uint8_t d = fd_readByte(&mf->_fd);
-                    mf_setTimeSignature(mf, n, 1 << d);  // denominator is 2^n
-                    mf->_mev.data[0] = n;
-                    mf->_mev.data[1] = d;
-                    mf->_mev.data[2] = 0;
-                    mf->_mev.data[3] = 0;
-                    DUMP("SET TIME SIGNATURE to %d/%d", mf_getTimeSignature(mf) >> 8, mf_getTimeSignature(mf) & 0xf);
-                }
-                break;
-
-                #if DUMP_DATA
-                case 0x59:  // Key Signature
-                {
-                        int8_t sf = fd_readByte(&mf->_fd);
-                        uint8_t mi = fd_readByte(&mf->_fd);
-                        mf->_mev.data[0] = sf;
-                        mf->_mev.data[1] = mi;
-
-                        DUMP("KEY SIGNATURE");
-                        const char* aaa[] = {"Cb", "Gb", "Db", "Ab", "Eb", "Bb", "F", "C", "G", "D", "A", "E", "B", "F#", "C#", "G#", "D#", "A#"};
-                        if (sf >= -7 && sf <= 7) 
-                        {
-                            switch(mi)
-                            {
-                            case 0:
-                                strcpy(mev.chars, aaa[sf+7]);
-                                strcat(mev.chars, "M");
-                                break;
-                            case 1:
-                                strcpy(mev.chars, aaa[sf+10]);
-                                strcat(mev.chars, "m");
-                                break;
-                            default:
-                                strcpy(mev.chars, "Err"); // error mi
-                            }
-                        }
-                        else
-                        {
-                            strcpy(mev.chars, "Err"); // error sf
-                        }
-                        mev.size = strlen(mev.chars); // change META length
-                        DUMP("[%s]", mev.chars);
-                }
-                break;
-
-                case 0x00:  // Sequence Number
-                {
-                    uint16_t x = fd_readMultiByte(&mf->_fd, MB_WORD);
-                    mev.data[0] = (x >> 8) & 0xFF;
-                    mev.data[1] = x & 0xFF;
-                    DUMP("SEQUENCE NUMBER %02x %02x", mev.data[0], mev.data[1]);
-                }
-                break;
-
-                case 0x20:  // Channel Prefix
-                {
-                    mev.data[0] = fd_readMultiByte(&mf->_fd, MB_BYTE);
-                    DUMP("CHANNEL PREFIX %02x", mev.data[0]);
+                    mf->_timeSignature[0] = fd_readByte(&mf->_fd);
+                    mf->_timeSignature[1] = 1 << fd_readByte(&mf->_fd);  // denominator is 2^n
                 }
                 break;
-
-                case 0x21:  // Port Prefix
-                {
-                    mev.data[0] = fd_readMultiByte(&mf->_fd, MB_BYTE);
-                    DUMP("PORT PREFIX %02x", mev.data[0]);
-                }
-                break;
-                #endif
-
-                #if SHOW_UNUSED_META
-                case 0x01:  // Text
-                    DUMPS("TEXT ");
-                    for (uint8_t_t i=0; i<mLen; i++)
-                        DUMP("", (char)mf->_fd.read());
-                    break;
-                case 0x02:  // Copyright Notice
-                    DUMPS("COPYRIGHT ");
-                    for (uint8_t_t i=0; i<mLen; i++)
-                        DUMP("", (char)mf->_fd.read());
-                    break;
-                case 0x03:  // Sequence or Track Name
-                    DUMPS("SEQ/TRK NAME ");
-                    for (uint8_t_t i=0; i<mLen; i++)
-                        DUMP("", (char)mf->_fd.read());
-                    break;
-                case 0x04:  // Instrument Name
-                    DUMPS("INSTRUMENT ");
-                    for (uint8_t_t i=0; i<mLen; i++)
-                        DUMP("", (char)mf->_fd.read());
-                    break;
-
-                case 0x05:  // Lyric
-                    DUMPS("LYRIC ");
-                    for (uint8_t_t i=0; i<mLen; i++)
-                        DUMP("", (char)mf->_fd.read());
-                    break;
-
-                case 0x06:  // Marker
-                    DUMPS("MARKER ");
-                    for (uint8_t_t i=0; i<mLen; i++)
-                        DUMP("", (char)mf->_fd.read());
-                    break;
-
-                case 0x07:  // Cue Point
-                    DUMPS("CUE POINT ");
-                    for (uint8_t_t i=0; i<mLen; i++)
-                        DUMP("", (char)mf->_fd.read());
-                    break;
-
-                case 0x54:  // SMPTE Offset
-                    DUMPS("SMPTE OFFSET");
-                    for (uint8_t_t i=0; i<mLen; i++)
-                        DUMP(" ", mf->_fd.read());
-                    break;
-
-                case 0x7F:  // Sequencer Specific Metadata
-                    DUMPS("SEQ SPECIFIC");
-                    for (uint8_t_t i=0; i<mLen; i++)
-                        DUMPX(" ", mf->_fd.read());
-                    break;
-                #endif // SHOW_UNUSED_META
-
-                default:
-                {
-                    if (mf->_metaHandler) {
-                        uint8_t minLen = min(ARRAY_SIZE(mf->_mev.data)-1, mLen);
-                        fd_read(&mf->_fd, mf->_mev.data, minLen);
-                        mf->_mev.data[minLen] = 0; // in case it is a string
-                    }
-                }
-                break;
-            }
-
-            if (mf->_metaHandler) {
-                (mf->_metaHandler)(&mf->_mev);
             }
             fd_seekSet(&mf->_fd, pos + mLen);
         }
@@ -523,109 +301,136 @@ void mt_parseEvent(MD_MIDIFile* mf, MD_MFTrack* mt) {
             // stop playing this track as we cannot identify the eType
             mt->_endOfTrack = true;
             DUMP("[UKNOWN 0x%02x] Track aborted", eType);
+            return false;
         }
         break;
     }
-}
-
-static bool mt_getNextEvent(MD_MIDIFile *mf, MD_MFTrack *mt, uint16_t tickCount) {
-    // track_event = <time:v> + [<midi_event> | <meta_event> | <sysex_event>]
-
-    // is there anything to process?
-    if (mt->_endOfTrack)
-        return(false);
-
-    // move the file pointer to where we left off
-    fd_seekSet(&mf->_fd, mt->_startOffset+mt->_currOffset);
-
-    // Work out new total elapsed ticks - include the overshoot from
-    // last event.
-    mt->_elapsedTicks += tickCount;
-
-    // Get the DeltaT from the file in order to see if enough ticks have
-    // passed for the event to be active.
-    uint32_t deltaT = fd_readVarLen(&mf->_fd);
-
-    // If not enough ticks, just return without saving the file pointer and 
-    // we will go back to the same spot next time.
-    if (mt->_elapsedTicks < deltaT)
-        return(false);
-
-    // Adjust the total elapsed time to the error against actual DeltaT to avoid 
-    // accumulation of errors, as we only check for _elapsedTicks being >= ticks,
-    // giving positive biased errors every time.
-    mt->_elapsedTicks -= deltaT;
-
-    DUMP("dT: %d + %d", deltaT, mt->_elapsedTicks);
-
-    mt_parseEvent(mf, mt);
 
     // remember the offset for next time
     mt->_currOffset = fd_pos(&mf->_fd) - mt->_startOffset;
-
-    // catch end of track when there is no META event  
-    mt->_endOfTrack = mt->_endOfTrack || (mt->_currOffset >= mt->_length);
-    if (mt->_endOfTrack) { DUMP(" - OUT OF TRACK"); }
-
-    return(true);
+    return true;
 }
 
 
-
-
-
 // ---------------------------------------------------------------------------------------------
 // midi file internal
 // ---------------------------------------------------------------------------------------------
 
-static inline bool mf_getNextEvent(MD_MIDIFile* mf) {
+// Merges the tracks into one array of events, sorted by time. Events at the
+// same tick keep the track order, tempo changes apply to the ticks after them.
+static bool mf_decode(MD_MIDIFile* mf) {
+    uint32_t usPerQuarterNote = 500000;     // 120 beats per minute
+    uint64_t tickTime = 0;                  // microseconds times ticks per quarter note
+    uint32_t lastTick = 0;
+    uint32_t allocated = 0;
 
-    DUMP("mf_GetNextEvent");
-    // if we are paused we are paused!
-    if (mf->_paused) 
-        return false;
+    for (uint16_t i = 0; i < mf->_trackCount; i++) {
+        mt_restart(&mf->_track[i]);
+        mt_readDeltaTime(mf, &mf->_track[i]);
+    }
 
-    // sync start all the tracks if we need to
-    if (!mf->_synchDone)
-    {
-        DUMP("mf_GetNextEvent: sync");
-        mf_synchTracks(mf);
-        mf->_synchDone = true;
+    mf->_eventCount = 0;
+    for (;;) {
+        MD_MFTrack* mt = null;
+        for (uint16_t i = 0; i < mf->_trackCount; i++) {
+            MD_MFTrack* t = &mf->_track[i];
+            if (!t->_endOfTrack && (!mt || t->_nextTick < mt->_nextTick))
+                mt = t;
+        }
+        if (!mt)
+            break;
+
+        if (mf->_eventCount == allocated) {
+            allocated = allocated ? allocated * 2 : 1024;
+            MD_event* events = realloc(mf->_events, allocated * sizeof(MD_event));
+            if (!events) {
+                err("Failed to allocate midi events");
+                free(mf->_events);
+                mf->_events = null;
+                return false;
+            }
+            mf->_events = events;
+        }
+
+        tickTime += (uint64_t) (mt->_nextTick - lastTick) * usPerQuarterNote;
+        lastTick = mt->_nextTick;
+
+        MD_event* ev = &mf->_events[mf->_eventCount];
+        ev->time = tickTime / mf->_ticksPerQuarterNote;
+        if (mt_decodeEvent(mf, mt, ev, &usPerQuarterNote))
+            mf->_eventCount++;
+        mt_readDeltaTime(mf, mt);
     }
 
-    // check if enough time has passed for a MIDI tick
-    uint16_t ticks = mf_tickClock(mf);
+    dbg("Midi events = %d", mf->_eventCount);
+    return true;
+}
 
-    DUMP("mf_GetNextEvent: ticks %d", ticks);
+static void mf_playSysex(MD_MIDIFile* mf, const MD_event* ev) {
+    // collect all the bytes until the 0xf7 - boundaries are included in the message
+    uint16_t index = 0;
+    fd_seekSet(&mf->_fd, ev->offset);
+    uint8_t eType = fd_readByte(&mf->_fd);
+    mf->_sev.track = ev->mev.track;
+    mf->_sev.size = fd_readVarLen(&mf->_fd);
+    if (eType==0xF0) {
+        mf->_sev.data[index++] = eType;
+        mf->_sev.size++;
+    }
 
-//    dbg("tick = %d", ticks);
-//    return true;
+    // The length parameter includes the 0xF7 but not the start boundary.
+    // However, it may be bigger than our buffer will allow us to store.
+    if (mf->_sev.size <= ARRAY_SIZE(mf->_sev.data)) {
+        fd_read(&mf->_fd, &mf->_sev.data[index], mf->_sev.size - index);
+        (mf->_sysexHandler)(&mf->_sev);
+    }
+}
 
-    if (ticks == 0)
-        return false;
+static void mf_playMeta(MD_MIDIFile* mf, const MD_event* ev) {
+    fd_seekSet(&mf->_fd, ev->offset + 1);
+    mf->_mev.track = ev->mev.track;
+    mf->_mev.type = fd_readByte(&mf->_fd);
+    mf->_mev.size = fd_readVarLen(&mf->_fd);
+    uint8_t minLen = min(ARRAY_SIZE(mf->_mev.data)-1, mf->_mev.size);
+    fd_read(&mf->_fd, mf->_mev.data, minLen);
+    mf->_mev.data[minLen] = 0; // in case it is a string
+    (mf->_metaHandler)(&mf->_mev);
+}
 
-    DUMP("mf_GetNextEvent: tracks %d", mf->_trackCount);
+static void mf_playEvent(MD_MIDIFile* mf, const MD_event* ev) {
+    switch (ev->type)
+    {
+        case MD_EVENT_MIDI:
+        {
+            // handlers may change the message, they get a copy
+            if (mf->_midiHandler != null) {
+                MD_midi_event mev = ev->mev;
+                (mf->_midiHandler)(&mev);
+            }
+        }
+        break;
 
-    for (uint16_t i = 0; i < mf->_trackCount; i++) {
-        // Limit n to be a sensible number of events in the loop counter
-        // When there are no more events, just break out
-        // Other than the first event, the others have an elapsed time of 0 (ie occur simultaneously)
-        for (uint8_t n=0; n < 100; n++) {
-            if (!mt_getNextEvent(mf, &mf->_track[i], n==0 ? ticks : 0))
-                break;
+        case MD_EVENT_SYSEX:
+        {
+            if (mf->_sysexHandler != null)
+                mf_playSysex(mf, ev);
         }
-    }
+        break;
 
-    return(true);
+        case MD_EVENT_META:
+        {
+            if (mf->_metaHandler != null)
+                mf_playMeta(mf, ev);
+        }
+        break;
+    }
 }
 
 static bool mf_init(MD_MIDIFile* mf) {
     mf->_paused = true;
-    mf_setTicksPerQuarterNote(mf, 48);                 // 48 ticks per quarter note
-    mf_setTempo(mf, 120);                              // 120 beats per minute
-    mf_setTempoAdjust(mf, 0);                          // 0 beats per minute adjustment
-    mf_setMicrosecondPerQuarterNote(mf, 500000);      // 500,000 microseconds per quarter note
-    mf_setTimeSignature(mf, 4, 4);                     // 4/4 time
+    mf->_ticksPerQuarterNote = 48;                     // 48 ticks per quarter note
+    mf->_timeSignature[0] = 4;                         // 4/4 time
+    mf->_timeSignature[1] = 4;
     for (uint16_t i=0; i<MIDI_MAX_TRACKS; i++) {
         mt_reset(&mf->_track[i]);
     }
@@ -684,7 +489,10 @@ static bool mf_init(MD_MIDIFile* mf) {
         }
         mf->_ticksPerQuarterNote = framespersecond * resolution;
     } 
-    mf_calcTickTime(mf);  // we may have changed from default, so recalculate
+    if (mf->_ticksPerQuarterNote == 0) {
+        err("Invalid time base");
+        return false;
+    }
 
     // load tracks
     bool failed = false;
@@ -721,7 +529,7 @@ static bool mf_init(MD_MIDIFile* mf) {
         fd_seekSet(&mf->_fd, mt->_startOffset+mt->_length);
     }
 
-    return !failed;
+    return !failed && mf_decode(mf);
 }
 
 // ---------------------------------------------------------------------------------------------
@@ -731,7 +539,24 @@ static bool mf_init(MD_MIDIFile* mf) {
 void MD_Update(MD_MIDIFile* mf, uint32_t microSeconds)
 {
     currentMicros = microSeconds;
-    mf_getNextEvent(mf);
+
+    // if we are paused we are paused!
+    if (mf->_paused) 
+        return;
+
+    // sync the start of the song if we need to
+    if (!mf->_synchDone) {
+        mf->_songTime = 0;
+        mf->_lastTickCheckTime = micros();
+        mf->_synchDone = true;
+    }
+
+    mf->_songTime += micros() - mf->_lastTickCheckTime;
+    mf->_lastTickCheckTime = micros();
+
+    while ((mf->_nextEvent < mf->_eventCount) && (mf->_events[mf->_nextEvent].time <= mf->_songTime)) {
+        mf_playEvent(mf, &mf->_events[mf->_nextEvent++]);
+    }
 }
 
 
@@ -774,23 +599,16 @@ void MD_Pause(MD_MIDIFile* mf, bool bMode) {
 }
 
 void MD_Restart(MD_MIDIFile* mf) {
-    // track 0 contains information that does not need to be reloaded every time, 
-    // so if we are looping, ignore restarting that track. The file may have one 
-    // track only and in this case always sync from track 0.
+    // the events are decoded already, going back is only rewinding to the first one
     dbg("Midi restart");
     MD_Pause(mf, true);
-    for (uint16_t i=0; i<mf->_trackCount; i++) {
-        mt_restart(&mf->_track[i]);
-    }
+    mf->_nextEvent = 0;
     mf->_synchDone = false;
     MD_Pause(mf, false);
 }
 
 bool MD_isEOF(MD_MIDIFile* mf) {
-    bool bEof = true;
-    for (uint16_t i=0; i<mf->_trackCount && bEof; i++) {
-        bEof = (mf->_track[i]._endOfTrack && bEof);
-    }
+    bool bEof = (mf->_nextEvent >= mf->_eventCount);
     if (bEof && mf->_looping) {
         MD_Restart(mf);
         bEof = false;
@@ -848,6 +666,7 @@ MD_MIDIFile* MD_OpenBuffer(uint8_t* buffer) {
 void MD_Close(MD_MIDIFile* mf) {
     dbg("Closing midi file");
     MD_Pause(mf, true);
+    free(mf->_events);
     free(mf);
 }
 
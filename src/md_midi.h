@@ -52,6 +52,21 @@ typedef struct
     uint8_t         data[256];
 } MD_meta_event;
 
+typedef enum
+{
+    MD_EVENT_MIDI,
+    MD_EVENT_SYSEX,
+    MD_EVENT_META
+} MD_event_type;
+
+typedef struct
+{
+    uint32_t        time;           ///< microseconds from the start of the song, tempo changes included
+    uint32_t        offset;         ///< sysex and meta events: offset of the status byte in the file
+    MD_midi_event   mev;            ///< midi events: the decoded message
+    uint8_t         type;           ///< MD_EVENT_MIDI, MD_EVENT_SYSEX or MD_EVENT_META
+} MD_event;
+
 typedef struct
 {
     uint8_t         _trackId;           ///< the id for this track
@@ -59,8 +74,8 @@ typedef struct
     uint32_t        _startOffset;       ///< start of the track in bytes from start of file
     uint32_t        _currOffset;        ///< offset from start of the track for the next read of SD data
     bool            _endOfTrack;        ///< true when we have reached end of track or we have encountered an undefined event
-    uint32_t        _elapsedTicks;      ///< the total number of elapsed ticks since last event
-    MD_midi_event   _mev;               ///< data for MIDI callback function - persists between calls for run-on messages
+    uint32_t        _nextTick;          ///< tick of the next event of the track, while decoding
+    MD_midi_event   _mev;               ///< last MIDI message - persists between events for run-on messages
 } MD_MFTrack;
 
 typedef struct
@@ -82,19 +97,19 @@ typedef struct {
     uint16_t        _trackCount;                                ///< number of tracks in file
 
     uint16_t        _ticksPerQuarterNote;                       ///< time base of file
-    uint32_t        _tickTime;                                  ///< calculated per tick based on other data for MIDI file
-    uint16_t        _lastTickError;                             ///< error brought forward from last tick check
-    uint32_t        _lastTickCheckTime;                         ///< the last time (microsec) an tick check was performed
+    uint32_t        _lastTickCheckTime;                         ///< the last time (microsec) the song was advanced
 
-    bool            _synchDone;                                 ///< sync up at the start of all tracks
+    bool            _synchDone;                                 ///< sync up at the start of the song
     bool            _paused;                                    ///< if true we are currently paused
     bool            _looping;                                   ///< if true we are currently looping
 
-    uint16_t        _tempo;                                     ///< tempo for this file in beats per minute
-    int16_t         _tempoDelta;                                ///< tempo offset adjustment in beats per minute
-
     uint8_t         _timeSignature[2];                          ///< time signature [0] = numerator, [1] = denominator
 
+    MD_event*       _events;                                    ///< all tracks merged and decoded at load time, by time
+    uint32_t        _eventCount;                                ///< number of events
+    uint32_t        _nextEvent;                                 ///< next event to play
+    uint32_t        _songTime;                                  ///< microseconds played from the start of the song
+
     MD_sysex_event  _sev;                                   ///< temporary sysex data
     MD_meta_event   _mev;                                   ///< temporary meta data
 
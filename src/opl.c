@@ -15,39 +15,65 @@
 //     OPL interface.
 //
 
+#ifdef __MINT__
 #include <mint/osbind.h>
+#endif
 #include "config.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include "SDL.h"
 
+#ifdef __MINT__
 #include "isa.h"
+#endif
 #include "opl.h"
+#include "opl_sw.h"
 
 static unsigned int opl_base = 0x388;       /* default Adlib port number */
 static unsigned int opl_delay_idx = 5;      /* default Adlib index write delay */
 static unsigned int opl_delay_reg = 35;     /* default Adlib data write delay */
 
+static int opl_software = 0;                /* emulated, see opl_sw.c */
+
 
 void OPL_WritePort(opl_port_t port, unsigned int value) {
-    isa_writeb(opl_base + port, value);
+#ifdef __MINT__
+    if (!opl_software) {
+        isa_writeb(opl_base + port, value);
+    }
+#endif
 }
 
 unsigned int OPL_ReadPort(opl_port_t port) {
-    return isa_readb(opl_base + port);
+#ifdef __MINT__
+    if (!opl_software) {
+        return isa_readb(opl_base + port);
+    }
+#endif
+    return 0;
 }
 
 void OPL_Delay(uint64_t us) {
-    isa_delay(us);
+#ifdef __MINT__
+    if (!opl_software) {
+        isa_delay(us);
+    }
+#endif
 }
 
 
 opl_init_result_t OPL_Init(unsigned int port_base)
 {
+    opl_software = 0;
+
+#ifdef __MINT__
     if (!isa_init()) {
         return OPL_INIT_NONE;
     }
+#else
+    return OPL_INIT_NONE;
+#endif
 
     opl_base = port_base;
     opl_init_result_t result = OPL_Detect();
@@ -64,8 +90,19 @@ opl_init_result_t OPL_Init(unsigned int port_base)
     return result;
 }
 
+// Without a chip, emulate one at the output rate.
+opl_init_result_t OPL_InitSoftware(unsigned int rate, int fast)
+{
+    opl_software = 1;
+    return OPL_SW_Init(rate, fast);
+}
+
 void OPL_Shutdown(void)
 {
+    if (opl_software) {
+        OPL_SW_Shutdown();
+        opl_software = 0;
+    }
 }
 
 // Higher-level functions, based on the lower-level functions above
@@ -78,6 +115,11 @@ unsigned int OPL_ReadStatus(void)
 // Write an OPL register value
 void OPL_WriteRegister(int reg, int value)
 {
+    if (opl_software) {
+        OPL_SW_WriteRegister(reg, value);
+        return;
+    }
+
     if (reg & 0x100) {
         OPL_WritePort(OPL_REGISTER_PORT_OPL3, reg - 0x100);
     } else {
@@ -177,7 +219,48 @@ void OPL_InitRegisters(int opl3)
     }
 }
 
+// Callbacks are only run by the emulation, timed by the music
+// it renders.
+
+void OPL_SetCallback(uint64_t us, opl_callback_t callback, void *data)
+{
+    if (opl_software) {
+        OPL_SW_SetCallback(us, callback, data);
+    }
+}
+
+void OPL_AdjustCallbacks(float factor)
+{
+    if (opl_software) {
+        OPL_SW_AdjustCallbacks(factor);
+    }
+}
+
+void OPL_ClearCallbacks(void)
+{
+    if (opl_software) {
+        OPL_SW_ClearCallbacks();
+    }
+}
+
+void OPL_Lock(void)
+{
+    if (opl_software) {
+        SDL_LockAudio();
+    }
+}
+
+void OPL_Unlock(void)
+{
+    if (opl_software) {
+        SDL_UnlockAudio();
+    }
+}
+
 void OPL_SetPaused(int paused)
 {
+    if (opl_software) {
+        OPL_SW_SetPaused(paused);
+    }
 }
 
@@ -78,6 +78,10 @@ typedef enum
 
 opl_init_result_t OPL_Init(unsigned int port_base);
 
+// Initialize software emulation instead, when no chip was found.
+
+opl_init_result_t OPL_InitSoftware(unsigned int rate, int fast);
+
 // Shut down the OPL subsystem.
 
 void OPL_Shutdown(void);
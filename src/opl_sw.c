@@ -0,0 +1,847 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//     Software OPL3, for when there is no chip.
+//     Two operators per voice, as GENMIDI instruments are, without
+//     the rhythm mode nor the timers. Operators work like the chip's,
+//     log-sin and exp tables, 9 bits envelopes in 0.1875 dB steps,
+//     but run straight at the output rate.
+//     It is rendered in the audio callback, which runs the OPL
+//     callbacks at the very sample they are due, so register
+//     writes from the music driver are applied in time, between
+//     two rendered blocks.
+//
+
+#include "config.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "SDL.h"
+
+#include "doomtype.h"
+#include "doomstat.h"
+#include "i_system.h"
+
+#include "opl.h"
+#include "opl_sw.h"
+
+#define OPL_CHIP_RATE       49716
+
+#define OPL_SW_VOICES       (OPL_NUM_VOICES * 2)
+#define OPL_SW_CALLBACKS    16
+
+// Samples rendered with the same envelopes and LFOs in fast mode.
+#define OPL_SW_BLOCK        16
+
+// Envelope levels, in 16.16 fixed point.
+#define ENV_BITS            16
+#define ENV_SILENT          (511 << ENV_BITS)
+
+#ifndef M_PI
+#define M_PI                3.14159265358979323846
+#endif
+
+typedef enum
+{
+    ENV_OFF,
+    ENV_ATTACK,
+    ENV_DECAY,
+    ENV_SUSTAIN,
+    ENV_RELEASE
+} opl_envstate_t;
+
+typedef struct
+{
+    // Registers.
+    int             am;
+    int             vib;
+    int             egtype;
+    int             ksr;
+    int             mult;
+    int             ksl;
+    int             tl;
+    int             ar;
+    int             dr;
+    int             sl;
+    int             rr;
+    int             wave;
+
+    // Computed from the registers and the voice frequency.
+    uint32_t        inc;            // phase step per output sample
+    int             kslatt;
+    int             attack;         // envelope steps per output sample
+    int             decay;
+    int             release;
+
+    uint32_t        phase;
+    opl_envstate_t  state;
+    int             env;
+    int             out;
+    int             prevout;        // for feedback
+
+} opl_op_t;
+
+typedef struct
+{
+    opl_op_t        op[2];          // modulator, carrier
+
+    int             fnum;
+    int             block;
+    int             key;
+    int             feedback;
+    int             additive;
+    int             left;
+    int             right;
+
+} opl_voice_t;
+
+typedef struct
+{
+    uint64_t        time;           // in microseconds
+    opl_callback_t  callback;
+    void*           data;
+
+} opl_sw_callback_t;
+
+static opl_voice_t  voices[OPL_SW_VOICES];
+
+static int          opl_rate;
+static int          opl_fast;
+static int          opl3mode;
+static int          opl_wse;
+static int          opl_nts;
+static int          opl_amdepth;
+static int          opl_vibdepth;
+
+static uint64_t     opl_time;       // samples rendered
+static uint64_t     opl_clock;      // microseconds, callbacks start from it
+static int          opl_paused;
+
+static opl_sw_callback_t    callbacks[OPL_SW_CALLBACKS];
+static int                  numcallbacks;
+
+// LFOs, for the current block.
+static int          lfo_trem;       // attenuation, in envelope steps
+static int          lfo_vib;        // 16.16 phase step factor, minus 1
+
+// Render cost.
+static unsigned int opl_render_us;
+static uint64_t     opl_render_samples;
+
+static uint16_t     logsin[256];
+static uint16_t     exptab[256];
+
+static const int    multtab[16] =
+{
+    1, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 20, 24, 24, 30, 30
+};
+
+static const int    ksltab[16] =
+{
+    0, 32, 40, 45, 48, 51, 53, 55, 56, 58, 59, 60, 61, 62, 63, 64
+};
+
+static const int    kslshift[4] = { 8, 1, 2, 0 };
+
+
+//
+// Tables of the chip: -log2(sin) of a quarter wave,
+// and 2^-x, both in 1/256.
+//
+static void InitTables(void)
+{
+    int i;
+
+    for (i = 0; i < 256; ++i)
+    {
+        logsin[i] = (uint16_t) floor(-log(sin((i + 0.5) * M_PI / 512))
+                                     / log(2.0) * 256 + 0.5);
+        exptab[i] = (uint16_t) floor(pow(2.0, -i / 256.0) * 2048 + 0.5);
+    }
+}
+
+
+//
+// Returns the steps per output sample, in 16.16 fixed point,
+// of an envelope rate, 4 times the register and the key scaling.
+// Every 4 rates doubles the speed, a rate of 4 fading out in
+// about 40 seconds.
+//
+static int EnvelopeSteps(int reg, int rof)
+{
+    int rate;
+
+    if (reg == 0)
+    {
+        return 0;
+    }
+
+    rate = reg * 4 + rof;
+    if (rate > 63)
+    {
+        rate = 63;
+    }
+
+    return (int) (((int64_t) (4 + (rate & 3)) << ((rate >> 2) + 1))
+                  * OPL_CHIP_RATE / opl_rate);
+}
+
+
+//
+// Updates what the operator computes from its registers,
+// and the frequency of its voice.
+//
+static void UpdateOperator(opl_voice_t *voice, opl_op_t *op)
+{
+    int rof;
+    int ksl;
+
+    // Phase step, 2^32 being a period.
+    op->inc = (uint32_t) (((uint64_t) (voice->fnum << voice->block)
+                           * multtab[op->mult] * OPL_CHIP_RATE << 11)
+                          / opl_rate);
+
+    // Key scale level.
+    ksl = (ksltab[voice->fnum >> 6] << 2) - ((8 - voice->block) << 5);
+    if (ksl < 0)
+    {
+        ksl = 0;
+    }
+    op->kslatt = ksl >> kslshift[op->ksl];
+
+    // Key scale rate.
+    rof = (voice->block << 1)
+        | ((opl_nts ? voice->fnum >> 8 : voice->fnum >> 9) & 1);
+    if (!op->ksr)
+    {
+        rof >>= 2;
+    }
+
+    op->attack = op->ar * 4 + rof >= 60 ? -1 : EnvelopeSteps(op->ar, rof);
+    op->decay = EnvelopeSteps(op->dr, rof);
+    op->release = EnvelopeSteps(op->rr, rof);
+}
+
+
+static void UpdateVoice(opl_voice_t *voice)
+{
+    UpdateOperator(voice, &voice->op[0]);
+    UpdateOperator(voice, &voice->op[1]);
+}
+
+
+static void KeyOn(opl_op_t *op)
+{
+    op->phase = 0;
+    if (op->attack < 0)
+    {
+        op->env = 0;
+        op->state = ENV_DECAY;
+    }
+    else
+    {
+        op->state = ENV_ATTACK;
+    }
+}
+
+
+static void KeyOff(opl_op_t *op)
+{
+    if (op->state != ENV_OFF)
+    {
+        op->state = ENV_RELEASE;
+    }
+}
+
+
+//
+// Runs the envelope of the operator for count samples.
+//
+static void RunEnvelope(opl_op_t *op, int count)
+{
+    int sl;
+
+    switch (op->state)
+    {
+        case ENV_ATTACK:
+            // Each step takes an eighth of the way to full level.
+            op->env -= (int) ((((int64_t) (op->env >> 3) + (1 << ENV_BITS))
+                               * op->attack >> ENV_BITS) * count);
+            if (op->env <= 0)
+            {
+                op->env = 0;
+                op->state = ENV_DECAY;
+            }
+            break;
+
+        case ENV_DECAY:
+            sl = op->sl == 15 ? 31 : op->sl;
+            sl <<= 4 + ENV_BITS;
+            op->env += op->decay * count;
+            if (op->env >= sl)
+            {
+                op->env = sl;
+                op->state = op->egtype ? ENV_SUSTAIN : ENV_RELEASE;
+            }
+            break;
+
+        case ENV_RELEASE:
+            op->env += op->release * count;
+            if (op->env >= ENV_SILENT)
+            {
+                op->env = ENV_SILENT;
+                op->state = ENV_OFF;
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+
+//
+// Attenuation of the operator, in envelope steps.
+//
+static int Attenuation(opl_op_t *op)
+{
+    int att;
+
+    att = (op->env >> ENV_BITS) + (op->tl << 2) + op->kslatt;
+    if (op->am)
+    {
+        att += lfo_trem;
+    }
+
+    return att > 511 ? 511 : att;
+}
+
+
+//
+// One sample of the operator, at phase plus mod, att being its
+// attenuation shifted to log-sin units.
+//
+static int Operator(opl_op_t *op, int mod, int att)
+{
+    unsigned int    phase;
+    unsigned int    level;
+    int             neg;
+    int             out;
+
+    phase = ((op->phase >> 22) + mod) & 1023;
+    neg = 0;
+
+    switch (op->wave)
+    {
+        default:
+        case 0:     // sine
+            neg = phase & 0x200;
+            level = logsin[phase & 0x100 ? 255 - (phase & 0xff) : phase & 0xff];
+            break;
+
+        case 1:     // half sine
+            if (phase & 0x200)
+            {
+                return 0;
+            }
+            level = logsin[phase & 0x100 ? 255 - (phase & 0xff) : phase & 0xff];
+            break;
+
+        case 2:     // absolute sine
+            level = logsin[phase & 0x100 ? 255 - (phase & 0xff) : phase & 0xff];
+            break;
+
+        case 3:     // quarter sine
+            if (phase & 0x100)
+            {
+                return 0;
+            }
+            level = logsin[phase & 0xff];
+            break;
+
+        case 4:     // double speed sine, every other period
+            if (phase & 0x200)
+            {
+                return 0;
+            }
+            neg = phase & 0x100;
+            level = logsin[phase & 0x80 ? 255 - ((phase << 1) & 0xff)
+                                        : (phase << 1) & 0xff];
+            break;
+
+        case 5:     // double speed absolute sine, every other period
+            if (phase & 0x200)
+            {
+                return 0;
+            }
+            level = logsin[phase & 0x80 ? 255 - ((phase << 1) & 0xff)
+                                        : (phase << 1) & 0xff];
+            break;
+
+        case 6:     // square
+            neg = phase & 0x200;
+            level = 0;
+            break;
+
+        case 7:     // derived square
+            neg = phase & 0x200;
+            if (neg)
+            {
+                phase = 0x3ff - phase;
+            }
+            level = (phase & 0x1ff) << 3;
+            break;
+    }
+
+    level += att;
+    if (level >= 0x1000)
+    {
+        return 0;
+    }
+
+    out = (exptab[level & 0xff] << 1) >> (level >> 8);
+
+    return neg ? -out : out;
+}
+
+
+//
+// Tremolo, a 3.7 Hz triangle of 1 or 4.8 dB,
+// and vibrato, a 6.1 Hz sine of 7 or 14 cents.
+//
+static void RunLFOs(uint64_t time)
+{
+    double lfo_time;
+    double tri;
+
+    // Both LFOs are back at their start every 100 seconds.
+    lfo_time = (double) (time % ((uint64_t) opl_rate * 100)) / opl_rate;
+
+    tri = fmod(lfo_time * 3.7, 1.0) * 2;
+    if (tri > 1.0)
+    {
+        tri = 2 - tri;
+    }
+    lfo_trem = (int) (tri * (opl_amdepth ? 25.6 : 5.3));
+
+    lfo_vib = (int) (sin(2 * M_PI * 6.1 * lfo_time)
+                     * (opl_vibdepth ? 0.0081 : 0.00405) * 65536);
+}
+
+
+//
+// Adds count samples of the voice to mix, with the envelopes
+// of the block.
+//
+static void RenderVoice(opl_voice_t *voice, int32_t *mix, int count)
+{
+    opl_op_t    *mod;
+    opl_op_t    *car;
+    uint32_t    modinc;
+    uint32_t    carinc;
+    int         modatt;
+    int         caratt;
+    int         fbshift;
+    int         in;
+    int         out;
+    int         i;
+
+    mod = &voice->op[0];
+    car = &voice->op[1];
+
+    modatt = Attenuation(mod) << 3;
+    caratt = Attenuation(car) << 3;
+
+    modinc = mod->inc;
+    carinc = car->inc;
+    if (mod->vib)
+    {
+        modinc += (uint32_t) (((int64_t) modinc * lfo_vib) >> 16);
+    }
+    if (car->vib)
+    {
+        carinc += (uint32_t) (((int64_t) carinc * lfo_vib) >> 16);
+    }
+
+    fbshift = voice->feedback ? 9 - voice->feedback : 0;
+
+    for (i = 0; i < count; ++i)
+    {
+        in = fbshift ? (mod->out + mod->prevout) >> fbshift : 0;
+        mod->prevout = mod->out;
+        mod->out = Operator(mod, in, modatt);
+        mod->phase += modinc;
+
+        if (voice->additive)
+        {
+            out = mod->out + Operator(car, 0, caratt);
+        }
+        else
+        {
+            out = Operator(car, mod->out, caratt);
+        }
+        car->phase += carinc;
+
+        if (voice->left)
+        {
+            mix[0] += out;
+        }
+        if (voice->right)
+        {
+            mix[1] += out;
+        }
+        mix += 2;
+    }
+}
+
+
+//
+// Adds count samples of all voices to mix.
+//
+static void RenderSamples(int32_t *mix, int count)
+{
+    opl_voice_t *voice;
+    int         step;
+    int         done;
+    int         i;
+
+    step = opl_fast ? OPL_SW_BLOCK : 1;
+
+    for (done = 0; done < count; done += step)
+    {
+        if (step > count - done)
+        {
+            step = count - done;
+        }
+
+        if (opl_fast || done == 0
+         || ((opl_time + done) & (OPL_SW_BLOCK - 1)) == 0)
+        {
+            RunLFOs(opl_time + done);
+        }
+
+        for (i = 0, voice = voices; i < OPL_SW_VOICES; ++i, ++voice)
+        {
+            // Silent, the chip would output nothing.
+            if (voice->op[1].state == ENV_OFF
+             && (!voice->additive || voice->op[0].state == ENV_OFF))
+            {
+                continue;
+            }
+
+            RenderVoice(voice, mix + done * 2, step);
+            RunEnvelope(&voice->op[0], step);
+            RunEnvelope(&voice->op[1], step);
+        }
+    }
+}
+
+
+//
+// Sample at which a callback runs. Callbacks keep microsecond
+// times and start the next ones from theirs, so that periodic
+// ones do not drift with the rounding.
+//
+static uint64_t CallbackSample(uint64_t us)
+{
+    return (us * opl_rate + OPL_SECOND - 1) / OPL_SECOND;
+}
+
+
+//
+// OPL_SW_Render
+// Adds count stereo samples to mix, running the callbacks
+// due meanwhile.
+//
+void OPL_SW_Render(int32_t *mix, int count)
+{
+    unsigned int    start;
+    uint64_t        end;
+    uint64_t        due;
+    uint64_t        now;
+    int             todo;
+    opl_callback_t  callback;
+    void            *data;
+    int             i;
+
+    start = I_GetTimeUS();
+    end = opl_time + count;
+
+    while (opl_time < end)
+    {
+        // Up to the next callback.
+        todo = (int) (end - opl_time);
+        if (!opl_paused && numcallbacks > 0)
+        {
+            due = CallbackSample(callbacks[0].time);
+            if (due < opl_time + todo)
+            {
+                todo = due > opl_time ? (int) (due - opl_time) : 0;
+            }
+        }
+
+        RenderSamples(mix, todo);
+        mix += todo * 2;
+        opl_time += todo;
+        now = opl_time * OPL_SECOND / opl_rate;
+
+        // Paused callbacks wait for the music.
+        if (opl_paused)
+        {
+            for (i = 0; i < numcallbacks; ++i)
+            {
+                callbacks[i].time += now - opl_clock;
+            }
+        }
+        opl_clock = now;
+
+        while (!opl_paused && numcallbacks > 0
+            && CallbackSample(callbacks[0].time) <= opl_time)
+        {
+            callback = callbacks[0].callback;
+            data = callbacks[0].data;
+            opl_clock = callbacks[0].time;
+            --numcallbacks;
+            for (i = 0; i < numcallbacks; ++i)
+            {
+                callbacks[i] = callbacks[i + 1];
+            }
+            callback(data);
+        }
+    }
+
+    opl_render_us += I_GetTimeUS() - start;
+    opl_render_samples += count;
+}
+
+
+//
+// OPL_SW_WriteRegister
+// The caller is either a callback run by OPL_SW_Render,
+// or holds the audio lock.
+//
+void OPL_SW_WriteRegister(int reg, int value)
+{
+    opl_voice_t *voice;
+    opl_op_t    *op;
+    int         bank;
+    int         offset;
+    int         index;
+
+    bank = reg & 0x100 ? OPL_NUM_VOICES : 0;
+    reg &= 0xff;
+
+    if ((reg >= 0x20 && reg < 0xa0) || reg >= 0xe0)
+    {
+        // Operators 0-5, 8-13 and 16-21 of the bank.
+        offset = reg & 0x1f;
+        if ((offset & 7) >= 6 || offset >= 22)
+        {
+            return;
+        }
+        index = (offset >> 3) * 3 + (offset & 7) % 3;
+        voice = &voices[bank + index];
+        op = &voice->op[(offset & 7) >= 3];
+
+        switch (reg & 0xe0)
+        {
+            case OPL_REGS_TREMOLO:
+                op->am = (value >> 7) & 1;
+                op->vib = (value >> 6) & 1;
+                op->egtype = (value >> 5) & 1;
+                op->ksr = (value >> 4) & 1;
+                op->mult = value & 0x0f;
+                break;
+            case OPL_REGS_LEVEL:
+                op->ksl = (value >> 6) & 3;
+                op->tl = value & 0x3f;
+                break;
+            case OPL_REGS_ATTACK:
+                op->ar = (value >> 4) & 0x0f;
+                op->dr = value & 0x0f;
+                break;
+            case OPL_REGS_SUSTAIN:
+                op->sl = (value >> 4) & 0x0f;
+                op->rr = value & 0x0f;
+                break;
+            case OPL_REGS_WAVEFORM:
+                op->wave = value & (opl3mode ? 7 : 3);
+                if (!opl3mode && !opl_wse)
+                {
+                    op->wave = 0;
+                }
+                break;
+        }
+        UpdateOperator(voice, op);
+        return;
+    }
+
+    if (reg >= 0xa0 && reg < 0xd0 && (reg & 0x0f) < OPL_NUM_VOICES)
+    {
+        voice = &voices[bank + (reg & 0x0f)];
+
+        switch (reg & 0xf0)
+        {
+            case OPL_REGS_FREQ_1:
+                voice->fnum = (voice->fnum & 0x300) | value;
+                UpdateVoice(voice);
+                break;
+
+            case OPL_REGS_FREQ_2:
+                voice->fnum = (voice->fnum & 0xff) | ((value & 3) << 8);
+                voice->block = (value >> 2) & 7;
+                UpdateVoice(voice);
+                if ((value & 0x20) && !voice->key)
+                {
+                    KeyOn(&voice->op[0]);
+                    KeyOn(&voice->op[1]);
+                }
+                else if (!(value & 0x20) && voice->key)
+                {
+                    KeyOff(&voice->op[0]);
+                    KeyOff(&voice->op[1]);
+                }
+                voice->key = (value >> 5) & 1;
+                break;
+
+            case OPL_REGS_FEEDBACK:
+                voice->feedback = (value >> 1) & 7;
+                voice->additive = value & 1;
+                voice->left = !opl3mode || (value & 0x10);
+                voice->right = !opl3mode || (value & 0x20);
+                break;
+        }
+        return;
+    }
+
+    switch (reg | (bank ? 0x100 : 0))
+    {
+        case OPL_REG_WAVEFORM_ENABLE:
+            opl_wse = value & 0x20;
+            break;
+        case OPL_REG_FM_MODE:
+            opl_nts = value & 0x40;
+            break;
+        case 0xbd:
+            opl_amdepth = value & 0x80;
+            opl_vibdepth = value & 0x40;
+            break;
+        case OPL_REG_NEW:
+            opl3mode = value & 1;
+            break;
+    }
+}
+
+
+//
+// OPL_SW_Init
+// Plays like an OPL3, at the output rate.
+//
+opl_init_result_t OPL_SW_Init(unsigned int rate, int fast)
+{
+    int i;
+
+    InitTables();
+
+    memset(voices, 0, sizeof(voices));
+    for (i = 0; i < OPL_SW_VOICES; ++i)
+    {
+        voices[i].op[0].env = ENV_SILENT;
+        voices[i].op[1].env = ENV_SILENT;
+        voices[i].left = voices[i].right = 1;
+    }
+
+    opl_rate = rate;
+    opl_fast = fast;
+    opl3mode = 0;
+    opl_wse = 0;
+    opl_nts = 0;
+    opl_amdepth = 0;
+    opl_vibdepth = 0;
+    opl_time = 0;
+    opl_clock = 0;
+    opl_paused = 0;
+    numcallbacks = 0;
+    opl_render_us = 0;
+    opl_render_samples = 0;
+
+    for (i = 0; i < OPL_SW_VOICES; ++i)
+    {
+        UpdateVoice(&voices[i]);
+    }
+
+    return OPL_INIT_OPL3;
+}
+
+
+//
+// OPL_SW_Shutdown
+// Tells what rendering cost, with -devparm.
+//
+void OPL_SW_Shutdown(void)
+{
+    if (devparm && opl_render_samples)
+    {
+        printf("OPL_SW_Shutdown: %s mode, %u us per second of music\n",
+               opl_fast ? "fast" : "normal",
+               (unsigned int) ((uint64_t) opl_render_us * opl_rate
+                               / opl_render_samples));
+    }
+}
+
+
+void OPL_SW_SetCallback(uint64_t us, opl_callback_t callback, void *data)
+{
+    uint64_t    time;
+    int         i;
+
+    if (numcallbacks == OPL_SW_CALLBACKS)
+    {
+        return;
+    }
+
+    time = opl_clock + us;
+
+    // Sorted by time, the same times in call order.
+    for (i = numcallbacks; i > 0 && callbacks[i - 1].time > time; --i)
+    {
+        callbacks[i] = callbacks[i - 1];
+    }
+    callbacks[i].time = time;
+    callbacks[i].callback = callback;
+    callbacks[i].data = data;
+    ++numcallbacks;
+}
+
+
+void OPL_SW_AdjustCallbacks(float factor)
+{
+    int i;
+
+    for (i = 0; i < numcallbacks; ++i)
+    {
+        callbacks[i].time = opl_clock
+            + (uint64_t) ((callbacks[i].time - opl_clock) * factor);
+    }
+}
+
+
+void OPL_SW_ClearCallbacks(void)
+{
+    numcallbacks = 0;
+}
+
+
+void OPL_SW_SetPaused(int paused)
+{
+    opl_paused = paused;
+}
@@ -0,0 +1,43 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//     Software OPL3, behind opl.c.
+//
+
+
+#ifndef OPL_OPL_SW_H
+#define OPL_OPL_SW_H
+
+#include "opl.h"
+
+// Start emulating at the output rate, fast mode runs the envelopes
+// and LFOs once per block of samples.
+
+opl_init_result_t OPL_SW_Init(unsigned int rate, int fast);
+
+// Print the render cost.
+
+void OPL_SW_Shutdown(void);
+
+// Add count stereo samples to mix, from the audio callback.
+
+void OPL_SW_Render(int32_t *mix, int count);
+
+void OPL_SW_WriteRegister(int reg, int value);
+
+void OPL_SW_SetCallback(uint64_t us, opl_callback_t callback, void *data);
+void OPL_SW_AdjustCallbacks(float factor);
+void OPL_SW_ClearCallbacks(void);
+void OPL_SW_SetPaused(int paused);
+
+#endif
+
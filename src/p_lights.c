@@ -67,7 +67,7 @@ void P_SpawnFireFlicker (sector_t*	sector)
     // Nothing special about it during gameplay.
     sector->special = 0; 
 	
-    flick = Z_Malloc ( sizeof(*flick), PU_LEVSPEC, 0);
+    flick = Z_PoolMalloc (&flickerpool);
 
     P_AddThinker (&flick->thinker);
 
@@ -122,7 +122,7 @@ void P_SpawnLightFlash (sector_t*	sector)
     // nothing special about it during gameplay
     sector->special = 0;	
 	
-    flash = Z_Malloc ( sizeof(*flash), PU_LEVSPEC, 0);
+    flash = Z_PoolMalloc (&flashpool);
 
     P_AddThinker (&flash->thinker);
 
@@ -179,7 +179,7 @@ P_SpawnStrobeFlash
 {
     strobe_t*	flash;
 	
-    flash = Z_Malloc ( sizeof(*flash), PU_LEVSPEC, 0);
+    flash = Z_PoolMalloc (&strobepool);
 
     P_AddThinker (&flash->thinker);
 
@@ -336,7 +336,7 @@ void P_SpawnGlowingLight(sector_t*	sector)
 {
     glow_t*	g;
 	
-    g = Z_Malloc( sizeof(*g), PU_LEVSPEC, 0);
+    g = Z_PoolMalloc (&glowpool);
 
     P_AddThinker(&g->thinker);
 
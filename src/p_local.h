@@ -21,6 +21,7 @@
 #define __P_LOCAL__
 
 #ifndef __R_LOCAL__
+#include "z_zone.h"
 #include "r_local.h"
 #endif
 
@@ -71,6 +72,19 @@ void P_InitThinkers (void);
 void P_AddThinker (thinker_t* thinker);
 void P_RemoveThinker (thinker_t* thinker);
 
+// the thinkers are allocated from these
+extern	zpool_t		mobjpool;
+extern	zpool_t		ceilingpool;
+extern	zpool_t		doorpool;
+extern	zpool_t		floorpool;
+extern	zpool_t		platpool;
+extern	zpool_t		flickerpool;
+extern	zpool_t		flashpool;
+extern	zpool_t		strobepool;
+extern	zpool_t		glowpool;
+
+void P_InitPools (void);
+
 
 //
 // P_PSPR
@@ -148,9 +162,10 @@ typedef struct
     }			d;
 } intercept_t;
 
+// Initial size, grows as needed.
 #define MAXINTERCEPTS	128
 
-extern intercept_t	intercepts[MAXINTERCEPTS];
+extern intercept_t*	intercepts;
 extern intercept_t*	intercept_p;
 
 typedef boolean (*traverser_t) (intercept_t *in);
@@ -209,6 +224,25 @@ boolean P_TryMove (mobj_t* thing, fixed_t x, fixed_t y);
 boolean P_TeleportMove (mobj_t* thing, fixed_t x, fixed_t y);
 void	P_SlideMove (mobj_t* mo);
 boolean P_CheckSight (mobj_t* t1, mobj_t* t2);
+
+// Sight checks, since last printed.
+typedef struct
+{
+    int		tics;
+    int		checks;
+    int		rejected;	// by REJECT
+    int		hits;		// done before in the same tic
+    int		nodes;		// crossed by P_CrossBSPNode
+    int		peakchecks;	// in one tic
+    int		peaknodes;
+
+} sightstats_t;
+
+extern sightstats_t	sightstats;
+
+void	P_ClearSightCache (void);
+void	P_StartSightTic (void);
+void	P_PrintSightStats (void);
 void 	P_UseLines (player_t* player);
 
 boolean P_ChangeSector (sector_t* sector, boolean crunch);
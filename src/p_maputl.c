@@ -21,8 +21,10 @@
 //-----------------------------------------------------------------------------
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "m_bbox.h"
+#include "z_zone.h"
 
 #include "doomdef.h"
 #include "p_local.h"
@@ -532,13 +534,47 @@ P_BlockThingsIterator
 //
 // INTERCEPT ROUTINES
 //
-intercept_t	intercepts[MAXINTERCEPTS];
+intercept_t*	intercepts=NULL;
 intercept_t*	intercept_p;
+static int	maxintercepts;
+static intercept_t*	sortintercepts;	// P_SortIntercepts scratch
 
 divline_t 	trace;
 boolean 	earlyout;
 int		ptflags;
 
+//
+// P_NewIntercept
+// Returns the next intercept, growing the list if full.
+//
+static intercept_t* P_NewIntercept (void)
+{
+    intercept_t*	grown;
+    int			count;
+
+    count = intercept_p - intercepts;
+
+    if (count == maxintercepts)
+    {
+	maxintercepts = maxintercepts ? maxintercepts*2 : MAXINTERCEPTS;
+	grown = Z_Malloc (maxintercepts*sizeof(intercept_t), PU_STATIC, NULL);
+	if (intercepts)
+	{
+	    memcpy (grown, intercepts, count*sizeof(intercept_t));
+	    Z_Free (intercepts);
+	    Z_Free (sortintercepts);
+	}
+	intercepts = grown;
+	intercept_p = intercepts + count;
+
+	sortintercepts = Z_Malloc (maxintercepts/2*sizeof(intercept_t),
+				   PU_STATIC, NULL);
+    }
+
+    return intercept_p++;
+}
+
+
 //
 // PIT_AddLineIntercepts.
 // Looks for lines in the given block
@@ -556,6 +592,7 @@ PIT_AddLineIntercepts (line_t* ld)
     int			s2;
     fixed_t		frac;
     divline_t		dl;
+    intercept_t*	in;
 	
     // avoid precision problems with two routines
     if ( trace.dx > FRACUNIT*16
@@ -591,10 +628,10 @@ PIT_AddLineIntercepts (line_t* ld)
     }
     
 	
-    intercept_p->frac = frac;
-    intercept_p->isaline = true;
-    intercept_p->d.line = ld;
-    intercept_p++;
+    in = P_NewIntercept ();
+    in->frac = frac;
+    in->isaline = true;
+    in->d.line = ld;
 
     return true;	// continue
 }
@@ -619,6 +656,7 @@ boolean PIT_AddThingIntercepts (mobj_t* thing)
     divline_t		dl;
     
     fixed_t		frac;
+    intercept_t*	in;
 	
     tracepositive = (trace.dx ^ trace.dy)>0;
 		
@@ -656,15 +694,66 @@ boolean PIT_AddThingIntercepts (mobj_t* thing)
     if (frac < 0)
 	return true;		// behind source
 
-    intercept_p->frac = frac;
-    intercept_p->isaline = false;
-    intercept_p->d.thing = thing;
-    intercept_p++;
+    in = P_NewIntercept ();
+    in->frac = frac;
+    in->isaline = false;
+    in->d.thing = thing;
 
     return true;		// keep going
 }
 
 
+//
+// P_SortIntercepts
+// Merge sort by frac. Intercepts at the same frac stay in the
+//  order they were added, the closest first scan of vanilla
+//  taking the first one of them.
+//
+static void P_SortIntercepts (intercept_t* in, int count)
+{
+    intercept_t	temp;
+    int		half;
+    int		i;
+    int		j;
+    int		k;
+
+    if (count <= 8)
+    {
+	for (i=1 ; i<count ; i++)
+	{
+	    temp = in[i];
+	    for (j=i ; j>0 && in[j-1].frac > temp.frac ; j--)
+		in[j] = in[j-1];
+	    in[j] = temp;
+	}
+	return;
+    }
+
+    half = count/2;
+    P_SortIntercepts (in, half);
+    P_SortIntercepts (in+half, count-half);
+
+    // Lines and things are mostly found in order.
+    if (in[half-1].frac <= in[half].frac)
+	return;
+
+    memcpy (sortintercepts, in, half*sizeof(intercept_t));
+
+    i = 0;
+    j = half;
+    k = 0;
+    while (i < half && j < count)
+    {
+	if (in[j].frac < sortintercepts[i].frac)
+	    in[k++] = in[j++];
+	else
+	    in[k++] = sortintercepts[i++];
+    }
+    while (i < half)
+	in[k++] = sortintercepts[i++];
+}
+
+
 //
 // P_TraverseIntercepts
 // Returns true if the traverser function returns true
@@ -675,46 +764,17 @@ P_TraverseIntercepts
 ( traverser_t	func,
   fixed_t	maxfrac )
 {
-    int			count;
-    fixed_t		dist;
-    intercept_t*	scan;
     intercept_t*	in;
-	
-    count = intercept_p - intercepts;
-    
-    in = 0;			// shut up compiler warning
-	
-    while (count--)
-    {
-	dist = MAXINT;
-	for (scan = intercepts ; scan<intercept_p ; scan++)
-	{
-	    if (scan->frac < dist)
-	    {
-		dist = scan->frac;
-		in = scan;
-	    }
-	}
-	
-	if (dist > maxfrac)
-	    return true;	// checked everything in range		
 
-#if 0  // UNUSED
+    P_SortIntercepts (intercepts, intercept_p - intercepts);
+
+    for (in = intercepts ; in<intercept_p ; in++)
     {
-	// don't check these yet, there may be others inserted
-	in = scan = intercepts;
-	for ( scan = intercepts ; scan<intercept_p ; scan++)
-	    if (scan->frac > maxfrac)
-		*in++ = *scan;
-	intercept_p = in;
-	return false;
-    }
-#endif
+	if (in->frac > maxfrac)
+	    return true;	// checked everything in range		
 
         if ( !func (in) )
 	    return false;	// don't bother going farther
-
-	in->frac = MAXINT;
     }
 	
     return true;		// everything was traversed
@@ -204,6 +204,8 @@ void P_UnArchiveWorld (void)
 	}
     }
     save_p = (byte *)get;	
+
+    P_ClearSightCache ();
 }
 
 
@@ -292,7 +294,7 @@ void P_UnArchiveThinkers (void)
 			
 	  case tc_mobj:
 	    PADSAVEP();
-	    mobj = Z_Malloc (sizeof(*mobj), PU_LEVEL, NULL);
+	    mobj = Z_PoolMalloc (&mobjpool);
 	    memcpy (mobj, save_p, sizeof(*mobj));
 	    save_p += sizeof(*mobj);
 	    mobj->state = &states[(int)mobj->state];
@@ -491,7 +493,7 @@ void P_UnArchiveSpecials (void)
 			
 	  case tc_ceiling:
 	    PADSAVEP();
-	    ceiling = Z_Malloc (sizeof(*ceiling), PU_LEVEL, NULL);
+	    ceiling = Z_PoolMalloc (&ceilingpool);
 	    memcpy (ceiling, save_p, sizeof(*ceiling));
 	    save_p += sizeof(*ceiling);
 	    ceiling->sector = &sectors[(int)ceiling->sector];
@@ -506,7 +508,7 @@ void P_UnArchiveSpecials (void)
 				
 	  case tc_door:
 	    PADSAVEP();
-	    door = Z_Malloc (sizeof(*door), PU_LEVEL, NULL);
+	    door = Z_PoolMalloc (&doorpool);
 	    memcpy (door, save_p, sizeof(*door));
 	    save_p += sizeof(*door);
 	    door->sector = &sectors[(int)door->sector];
@@ -517,7 +519,7 @@ void P_UnArchiveSpecials (void)
 				
 	  case tc_floor:
 	    PADSAVEP();
-	    floor = Z_Malloc (sizeof(*floor), PU_LEVEL, NULL);
+	    floor = Z_PoolMalloc (&floorpool);
 	    memcpy (floor, save_p, sizeof(*floor));
 	    save_p += sizeof(*floor);
 	    floor->sector = &sectors[(int)floor->sector];
@@ -528,7 +530,7 @@ void P_UnArchiveSpecials (void)
 				
 	  case tc_plat:
 	    PADSAVEP();
-	    plat = Z_Malloc (sizeof(*plat), PU_LEVEL, NULL);
+	    plat = Z_PoolMalloc (&platpool);
 	    memcpy (plat, save_p, sizeof(*plat));
 	    save_p += sizeof(*plat);
 	    plat->sector = &sectors[(int)plat->sector];
@@ -543,7 +545,7 @@ void P_UnArchiveSpecials (void)
 				
 	  case tc_flash:
 	    PADSAVEP();
-	    flash = Z_Malloc (sizeof(*flash), PU_LEVEL, NULL);
+	    flash = Z_PoolMalloc (&flashpool);
 	    memcpy (flash, save_p, sizeof(*flash));
 	    save_p += sizeof(*flash);
 	    flash->sector = &sectors[(int)flash->sector];
@@ -553,7 +555,7 @@ void P_UnArchiveSpecials (void)
 				
 	  case tc_strobe:
 	    PADSAVEP();
-	    strobe = Z_Malloc (sizeof(*strobe), PU_LEVEL, NULL);
+	    strobe = Z_PoolMalloc (&strobepool);
 	    memcpy (strobe, save_p, sizeof(*strobe));
 	    save_p += sizeof(*strobe);
 	    strobe->sector = &sectors[(int)strobe->sector];
@@ -563,7 +565,7 @@ void P_UnArchiveSpecials (void)
 				
 	  case tc_glow:
 	    PADSAVEP();
-	    glow = Z_Malloc (sizeof(*glow), PU_LEVEL, NULL);
+	    glow = Z_PoolMalloc (&glowpool);
 	    memcpy (glow, save_p, sizeof(*glow));
 	    save_p += sizeof(*glow);
 	    glow->sector = &sectors[(int)glow->sector];
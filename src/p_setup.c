@@ -141,7 +141,7 @@ void P_LoadVertexes (int lump)
     }
 
     // Free buffer memory.
-    Z_Free (data);
+    W_ReleaseLumpNum (lump);
 }
 
 
@@ -185,7 +185,7 @@ void P_LoadSegs (int lump)
 	    li->backsector = 0;
     }
 	
-    Z_Free (data);
+    W_ReleaseLumpNum (lump);
 }
 
 
@@ -213,7 +213,7 @@ void P_LoadSubsectors (int lump)
 	ss->firstline = SHORT(ms->firstseg);
     }
 	
-    Z_Free (data);
+    W_ReleaseLumpNum (lump);
 }
 
 
@@ -247,7 +247,7 @@ void P_LoadSectors (int lump)
 	ss->thinglist = NULL;
     }
 	
-    Z_Free (data);
+    W_ReleaseLumpNum (lump);
 }
 
 
@@ -284,7 +284,7 @@ void P_LoadNodes (int lump)
 	}
     }
 	
-    Z_Free (data);
+    W_ReleaseLumpNum (lump);
 }
 
 
@@ -339,7 +339,7 @@ void P_LoadThings (int lump)
 	P_SpawnMapThing (mt);
     }
 	
-    Z_Free (data);
+    W_ReleaseLumpNum (lump);
 }
 
 
@@ -421,7 +421,7 @@ void P_LoadLineDefs (int lump)
 	    ld->backsector = 0;
     }
 	
-    Z_Free (data);
+    W_ReleaseLumpNum (lump);
 }
 
 
@@ -452,7 +452,7 @@ void P_LoadSideDefs (int lump)
 	sd->sector = &sectors[SHORT(msd->sector)];
     }
 	
-    Z_Free (data);
+    W_ReleaseLumpNum (lump);
 }
 
 
@@ -464,7 +464,8 @@ void P_LoadBlockMap (int lump)
     int		i;
     int		count;
 	
-    blockmaplump = W_CacheLumpNum (lump,PU_LEVEL);
+    // swapped in place, so needs its own copy
+    blockmaplump = W_LoadLumpNum (lump,PU_LEVEL);
     blockmap = blockmaplump+4;
     count = W_LumpLength (lump)/2;
 
@@ -484,6 +485,19 @@ void P_LoadBlockMap (int lump)
 
 
 
+//
+// P_AddLineToSector
+// Adds the line to the sector line table,
+//  and its vertexes to the sector bounding box.
+//
+static void P_AddLineToSector (line_t* li, sector_t* sector)
+{
+    sector->lines[sector->linecount++] = li;
+    M_AddToBox (sector->blockbox, li->v1->x, li->v1->y);
+    M_AddToBox (sector->blockbox, li->v2->x, li->v2->y);
+}
+
+
 //
 // P_GroupLines
 // Builds sector line lists and subsector sector numbers.
@@ -493,7 +507,6 @@ void P_GroupLines (void)
 {
     line_t**		linebuffer;
     int			i;
-    int			j;
     int			total;
     line_t*		li;
     sector_t*		sector;
@@ -525,26 +538,34 @@ void P_GroupLines (void)
 	}
     }
 	
-    // build line tables for each sector	
+    // give each sector its part of the line table,
+    //  the bounding box is kept in blockbox for now
     linebuffer = Z_Malloc (total*4, PU_LEVEL, 0);
     sector = sectors;
     for (i=0 ; i<numsectors ; i++, sector++)
     {
-	M_ClearBox (bbox);
 	sector->lines = linebuffer;
-	li = lines;
-	for (j=0 ; j<numlines ; j++, li++)
-	{
-	    if (li->frontsector == sector || li->backsector == sector)
-	    {
-		*linebuffer++ = li;
-		M_AddToBox (bbox, li->v1->x, li->v1->y);
-		M_AddToBox (bbox, li->v2->x, li->v2->y);
-	    }
-	}
-	if (linebuffer - sector->lines != sector->linecount)
-	    I_Error ("P_GroupLines: miscounted");
-			
+	linebuffer += sector->linecount;
+	sector->linecount = 0;
+	M_ClearBox (sector->blockbox);
+    }
+
+    // build line tables for each sector, in a single pass,
+    //  the lines of a sector are still in linedef order
+    li = lines;
+    for (i=0 ; i<numlines ; i++, li++)
+    {
+	P_AddLineToSector (li, li->frontsector);
+
+	if (li->backsector && li->backsector != li->frontsector)
+	    P_AddLineToSector (li, li->backsector);
+    }
+
+    sector = sectors;
+    for (i=0 ; i<numsectors ; i++, sector++)
+    {
+	memcpy (bbox, sector->blockbox, sizeof(bbox));
+
 	// set the degenmobj_t to the middle of the bounding box
 	sector->soundorg.x = (bbox[BOXRIGHT]+bbox[BOXLEFT])/2;
 	sector->soundorg.y = (bbox[BOXTOP]+bbox[BOXBOTTOM])/2;
@@ -570,6 +591,26 @@ void P_GroupLines (void)
 }
 
 
+//
+// P_PhaseTime
+// With -devparm, shows how long each step of P_SetupLevel took.
+//
+static int	phasetime;
+static int	setuptime;
+
+static void P_PhaseTime (char* phase)
+{
+    int		now;
+
+    if (!devparm)
+	return;
+
+    now = I_GetTimeMS ();
+    printf ("P_SetupLevel: %-16s %5i ms\n", phase, now - phasetime);
+    phasetime = now;
+}
+
+
 //
 // P_SetupLevel
 //
@@ -599,6 +640,14 @@ P_SetupLevel
     // Make sure all sounds are stopped before Z_FreeTags.
     S_Start ();			
 
+    if (devparm)
+    {
+	Z_PoolStats ();
+	R_PrintRenderStats ();
+	R_PrintCompositeStats ();
+	P_PrintSightStats ();
+    }
+
     
 #if 0 // UNUSED
     if (debugfile)
@@ -637,24 +686,40 @@ P_SetupLevel
     lumpnum = W_GetNumForName (lumpname);
 	
     leveltime = 0;
+
+    phasetime = setuptime = I_GetTimeMS ();
 	
     // note: most of this ordering is important	
     P_LoadBlockMap (lumpnum+ML_BLOCKMAP);
+    P_PhaseTime ("P_LoadBlockMap");
     P_LoadVertexes (lumpnum+ML_VERTEXES);
+    P_PhaseTime ("P_LoadVertexes");
     P_LoadSectors (lumpnum+ML_SECTORS);
+    P_PhaseTime ("P_LoadSectors");
     P_LoadSideDefs (lumpnum+ML_SIDEDEFS);
+    P_PhaseTime ("P_LoadSideDefs");
 
     P_LoadLineDefs (lumpnum+ML_LINEDEFS);
+    P_PhaseTime ("P_LoadLineDefs");
     P_LoadSubsectors (lumpnum+ML_SSECTORS);
+    P_PhaseTime ("P_LoadSubsectors");
     P_LoadNodes (lumpnum+ML_NODES);
+    P_PhaseTime ("P_LoadNodes");
     P_LoadSegs (lumpnum+ML_SEGS);
+    P_PhaseTime ("P_LoadSegs");
 	
     rejectmatrix = W_CacheLumpNum (lumpnum+ML_REJECT,PU_LEVEL);
+    P_PhaseTime ("reject");
     P_GroupLines ();
+    P_PhaseTime ("P_GroupLines");
+    P_ClearSightCache ();
+    R_BuildPVS ();
+    P_PhaseTime ("R_BuildPVS");
 
     bodyqueslot = 0;
     deathmatch_p = deathmatchstarts;
     P_LoadThings (lumpnum+ML_THINGS);
+    P_PhaseTime ("P_LoadThings");
     
     // if deathmatch, randomly spawn the active players
     if (deathmatch)
@@ -673,13 +738,23 @@ P_SetupLevel
 	
     // set up world state
     P_SpawnSpecials ();
+    P_PhaseTime ("P_SpawnSpecials");
 	
     // build subsector connect matrix
     //	UNUSED P_ConnectSubsectors ();
 
     // preload graphics
     if (precache)
+    {
 	R_PrecacheLevel ();
+	P_PhaseTime ("R_PrecacheLevel");
+	S_PrecacheSounds ();
+	P_PhaseTime ("S_PrecacheSounds");
+    }
+
+    if (devparm)
+	printf ("P_SetupLevel: %-16s %5i ms\n", "total",
+		I_GetTimeMS () - setuptime);
 
     //printf ("free memory: 0x%x\n", Z_FreeMemory());
 
@@ -692,6 +767,7 @@ P_SetupLevel
 //
 void P_Init (void)
 {
+    P_InitPools ();
     P_InitSwitchList ();
     P_InitPicAnims ();
     R_InitSprites (sprnames);
@@ -17,6 +17,9 @@
 //
 //-----------------------------------------------------------------------------
 
+#include <stdio.h>
+#include <string.h>
+
 #include "doomdef.h"
 
 #include "i_system.h"
@@ -36,7 +39,96 @@ divline_t	strace;			// from t1 to t2
 fixed_t		t2x;
 fixed_t		t2y;
 
-int		sightcounts[2];
+sightstats_t	sightstats;
+
+// Nodes crossed since the start of the tic.
+static int	ticchecks;
+static int	ticnodes;
+
+
+//
+// Sight checks already done, with the positions they were done for.
+// The result only depends on these and on the sector heights,
+//  so it is the same as checking again until a plane moves.
+//
+#define SIGHTCACHESIZE	1024
+
+typedef struct
+{
+    sector_t*	s1;
+    sector_t*	s2;
+    fixed_t	x1;
+    fixed_t	y1;
+    fixed_t	z1;
+    fixed_t	height1;
+    fixed_t	x2;
+    fixed_t	y2;
+    fixed_t	z2;
+    fixed_t	height2;
+
+    int		stamp;
+    boolean	visible;
+
+} sightentry_t;
+
+static sightentry_t	sightcache[SIGHTCACHESIZE];
+static int		sightstamp = 1;
+
+
+//
+// P_ClearSightCache
+// Called when a plane moves, or when sectors are loaded.
+//
+void P_ClearSightCache (void)
+{
+    sightstamp++;
+}
+
+
+static void P_EndSightTic (void)
+{
+    if (ticchecks > sightstats.peakchecks)
+	sightstats.peakchecks = ticchecks;
+    if (ticnodes > sightstats.peaknodes)
+	sightstats.peaknodes = ticnodes;
+
+    ticchecks = 0;
+    ticnodes = 0;
+}
+
+
+//
+// P_StartSightTic
+// Called by P_Ticker, the cache only lasts one tic.
+//
+void P_StartSightTic (void)
+{
+    P_EndSightTic ();
+    sightstats.tics++;
+    sightstamp++;
+}
+
+
+//
+// P_PrintSightStats
+// Since last printed.
+//
+void P_PrintSightStats (void)
+{
+    if (!sightstats.tics)
+	return;
+
+    P_EndSightTic ();
+
+    printf ("P_PrintSightStats: %i tics, %i sight checks (at most %i in a tic),"
+	    " %i rejected, %i cache hits, %i nodes crossed"
+	    " (at most %i in a tic)\n",
+	    sightstats.tics, sightstats.checks, sightstats.peakchecks,
+	    sightstats.rejected, sightstats.hits, sightstats.nodes,
+	    sightstats.peaknodes);
+
+    memset (&sightstats, 0, sizeof(sightstats));
+}
 
 
 //
@@ -251,6 +343,9 @@ boolean P_CrossBSPNode (int bspnum)
     node_t*	bsp;
     int		side;
 
+    ticnodes++;
+    sightstats.nodes++;
+
     if (bspnum & NF_SUBSECTOR)
     {
 	if (bspnum == -1)
@@ -286,19 +381,23 @@ boolean P_CrossBSPNode (int bspnum)
 // P_CheckSight
 // Returns true
 //  if a straight line between t1 and t2 is unobstructed.
-// Uses REJECT.
+// Uses REJECT, then the checks already done in this tic.
 //
 boolean
 P_CheckSight
 ( mobj_t*	t1,
   mobj_t*	t2 )
 {
-    int		s1;
-    int		s2;
-    int		pnum;
-    int		bytenum;
-    int		bitnum;
+    int			s1;
+    int			s2;
+    int			pnum;
+    int			bytenum;
+    int			bitnum;
+    sightentry_t*	entry;
     
+    ticchecks++;
+    sightstats.checks++;
+
     // First check for trivial rejection.
 
     // Determine subsector entries in REJECT table.
@@ -311,16 +410,42 @@ P_CheckSight
     // Check in REJECT table.
     if (rejectmatrix[bytenum]&bitnum)
     {
-	sightcounts[0]++;
+	sightstats.rejected++;
 
 	// can't possibly be connected
 	return false;	
     }
 
+    // Same looker and target, from the same places?
+    entry = &sightcache[((((size_t)t1>>4) * 0x9e3779b1UL)
+			 ^ ((size_t)t2>>4)) & (SIGHTCACHESIZE-1)];
+
+    if (entry->stamp == sightstamp
+	&& entry->x1 == t1->x && entry->y1 == t1->y
+	&& entry->x2 == t2->x && entry->y2 == t2->y
+	&& entry->z1 == t1->z && entry->height1 == t1->height
+	&& entry->z2 == t2->z && entry->height2 == t2->height
+	&& entry->s1 == t1->subsector->sector
+	&& entry->s2 == t2->subsector->sector)
+    {
+	sightstats.hits++;
+	return entry->visible;
+    }
+
+    entry->stamp = sightstamp;
+    entry->s1 = t1->subsector->sector;
+    entry->s2 = t2->subsector->sector;
+    entry->x1 = t1->x;
+    entry->y1 = t1->y;
+    entry->z1 = t1->z;
+    entry->height1 = t1->height;
+    entry->x2 = t2->x;
+    entry->y2 = t2->y;
+    entry->z2 = t2->z;
+    entry->height2 = t2->height;
+
     // An unobstructed LOS is possible.
     // Now look from eyes of t1 to any part of t2.
-    sightcounts[1]++;
-
     validcount++;
 	
     sightzstart = t1->z + t1->height - (t1->height>>2);
@@ -335,5 +460,7 @@ P_CheckSight
     strace.dy = t2->y - t1->y;
 
     // the head node is the last node output
-    return P_CrossBSPNode (numnodes-1);	
+    entry->visible = P_CrossBSPNode (numnodes-1);
+
+    return entry->visible;
 }
@@ -30,8 +30,9 @@ int	leveltime;
 
 //
 // THINKERS
-// All thinkers should be allocated by Z_Malloc
-// so they can be operated on uniformly.
+// All thinkers should be allocated from a pool
+// so they can be operated on uniformly, Z_Free
+// gives them back to their pool.
 // The actual structures will vary in size,
 // but the first element must be thinker_t.
 //
@@ -41,6 +42,34 @@ int	leveltime;
 // Both the head and tail of the thinker list.
 thinker_t	thinkercap;
 
+zpool_t		mobjpool;
+zpool_t		ceilingpool;
+zpool_t		doorpool;
+zpool_t		floorpool;
+zpool_t		platpool;
+zpool_t		flickerpool;
+zpool_t		flashpool;
+zpool_t		strobepool;
+zpool_t		glowpool;
+
+
+//
+// P_InitPools
+// Only at game startup.
+//
+void P_InitPools (void)
+{
+    Z_InitPool (&mobjpool, "mobj", sizeof(mobj_t), PU_LEVEL);
+    Z_InitPool (&ceilingpool, "ceiling", sizeof(ceiling_t), PU_LEVSPEC);
+    Z_InitPool (&doorpool, "door", sizeof(vldoor_t), PU_LEVSPEC);
+    Z_InitPool (&floorpool, "floor", sizeof(floormove_t), PU_LEVSPEC);
+    Z_InitPool (&platpool, "plat", sizeof(plat_t), PU_LEVSPEC);
+    Z_InitPool (&flickerpool, "flicker", sizeof(fireflicker_t), PU_LEVSPEC);
+    Z_InitPool (&flashpool, "flash", sizeof(lightflash_t), PU_LEVSPEC);
+    Z_InitPool (&strobepool, "strobe", sizeof(strobe_t), PU_LEVSPEC);
+    Z_InitPool (&glowpool, "glow", sizeof(glow_t), PU_LEVSPEC);
+}
+
 
 //
 // P_InitThinkers
@@ -140,6 +169,8 @@ void P_Ticker (void)
     }
     
 		
+    P_StartSightTic ();
+
     for (i=0 ; i<MAXPLAYERS ; i++)
 	if (playeringame[i])
 	    P_PlayerThink (&players[i]);
@@ -18,26 +18,30 @@
 //-----------------------------------------------------------------------------
 
 #include <stdio.h>
+#include <string.h>
 
 #include "doomdef.h"
 #include "m_bbox.h"
 #include "i_system.h"
+#include "z_zone.h"
 #include "r_main.h"
 #include "r_plane.h"
 #include "r_things.h"
+#include "r_pvs.h"
 
 // State.
 #include "doomstat.h"
 #include "r_state.h"
 
-seg_t*		curline;
+R_THREADLOCAL seg_t*		curline;
 side_t*		sidedef;
 line_t*		linedef;
-sector_t*	frontsector;
-sector_t*	backsector;
+R_THREADLOCAL sector_t*	frontsector;
+R_THREADLOCAL sector_t*	backsector;
 
-drawseg_t	drawsegs[MAXDRAWSEGS];
+drawseg_t*	drawsegs=NULL;
 drawseg_t*	ds_p;
+static int	maxdrawsegs;
 
 
 void
@@ -53,10 +57,41 @@ R_StoreWallRange
 //
 void R_ClearDrawSegs (void)
 {
+    if (!drawsegs)
+    {
+	maxdrawsegs = MAXDRAWSEGS;
+	drawsegs = Z_Malloc (maxdrawsegs*sizeof(drawseg_t), PU_STATIC, NULL);
+    }
+
     ds_p = drawsegs;
 }
 
 
+//
+// R_GrowDrawSegs
+// Called by R_StoreWallRange,
+//  doubles the drawsegs when all are used.
+//
+void R_GrowDrawSegs (void)
+{
+    drawseg_t*	newdrawsegs;
+    int		numdrawsegs;
+
+    if (ds_p < drawsegs + maxdrawsegs)
+	return;
+
+    numdrawsegs = ds_p - drawsegs;
+
+    newdrawsegs = Z_Malloc (2*maxdrawsegs*sizeof(drawseg_t), PU_STATIC, NULL);
+    memcpy (newdrawsegs, drawsegs, numdrawsegs*sizeof(drawseg_t));
+    Z_Free (drawsegs);
+
+    drawsegs = newdrawsegs;
+    ds_p = drawsegs + numdrawsegs;
+    maxdrawsegs *= 2;
+}
+
+
 
 //
 // ClipWallSegment
@@ -540,13 +575,27 @@ void R_RenderBSPNode (int bspnum)
     node_t*	bsp;
     int		side;
 
+    renderstats.bspnodes++;
+
     // Found a subsector?
     if (bspnum & NF_SUBSECTOR)
     {
 	if (bspnum == -1)			
-	    R_Subsector (0);
+	    bspnum = 0;
+	else
+	    bspnum &= ~NF_SUBSECTOR;
+
+	if (pvssubsectors && !pvssubsectors[bspnum])
+	    renderstats.pvsskipped++;
 	else
-	    R_Subsector (bspnum&(~NF_SUBSECTOR));
+	    R_Subsector (bspnum);
+	return;
+    }
+
+    // Nothing below can be seen from the view sector.
+    if (pvsnodes && !pvsnodes[bspnum])
+    {
+	renderstats.pvsskipped++;
 	return;
     }
 		
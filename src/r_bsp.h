@@ -20,11 +20,11 @@
 #ifndef __R_BSP__
 #define __R_BSP__
 
-extern seg_t*		curline;
+extern R_THREADLOCAL seg_t*	curline;
 extern side_t*		sidedef;
 extern line_t*		linedef;
-extern sector_t*	frontsector;
-extern sector_t*	backsector;
+extern R_THREADLOCAL sector_t*	frontsector;
+extern R_THREADLOCAL sector_t*	backsector;
 
 extern int		rw_x;
 extern int		rw_stopx;
@@ -37,7 +37,7 @@ extern boolean		markceiling;
 
 extern boolean		skymap;
 
-extern drawseg_t	drawsegs[MAXDRAWSEGS];
+extern drawseg_t*	drawsegs;
 extern drawseg_t*	ds_p;
 
 extern lighttable_t**	hscalelight;
@@ -51,6 +51,7 @@ typedef void (*drawfunc_t) (int start, int stop);
 // BSP?
 void R_ClearClipSegs (void);
 void R_ClearDrawSegs (void);
+void R_GrowDrawSegs (void);
 
 
 void R_RenderBSPNode (int bspnum);
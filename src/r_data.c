@@ -152,6 +152,69 @@ fixed_t*	spritetopoffset;
 lighttable_t	*colormaps;
 
 
+//
+// Cache pinning.
+// While the view is drawn by several threads, every graphic
+//  used by the frame is kept PU_STATIC, so the zone never purges
+//  it under a drawing thread, and only the main thread allocates.
+//
+boolean		r_pincache;
+
+static void**	pinned=NULL;
+static int	numpinned;
+static int	maxpinned;
+
+static void R_PinBlock (void* ptr)
+{
+    memblock_t*	block;
+    void**	newpinned;
+
+    block = (memblock_t *) ((byte *)ptr - sizeof(memblock_t));
+
+    // allready pinned, or never purged anyway
+    if (block->tag < PU_PURGELEVEL)
+	return;
+
+    Z_ChangeTag (ptr, PU_STATIC);
+
+    if (numpinned == maxpinned)
+    {
+	maxpinned = maxpinned ? maxpinned*2 : 256;
+	newpinned = Z_Malloc (maxpinned*sizeof(void *), PU_STATIC, NULL);
+	if (pinned)
+	{
+	    memcpy (newpinned, pinned, numpinned*sizeof(void *));
+	    Z_Free (pinned);
+	}
+	pinned = newpinned;
+    }
+    pinned[numpinned++] = ptr;
+}
+
+
+//
+// R_CacheLumpNum
+// Same as W_CacheLumpNum(lump,PU_CACHE) for the refresh,
+//  but pins the lump while r_pincache is set.
+//
+void* R_CacheLumpNum (int lump)
+{
+    void*	ptr;
+
+    // mapped lumps are never purged
+    if (!r_pincache || lumpinfo[lump].mapped)
+	return W_CacheLumpNum (lump, PU_CACHE);
+
+    // W_CacheLumpNum would drop a pinned lump back to PU_CACHE
+    ptr = lumpcache[lump];
+    if (!ptr)
+	ptr = W_CacheLumpNum (lump, PU_CACHE);
+
+    R_PinBlock (ptr);
+    return ptr;
+}
+
+
 //
 // MAPTEXTURE_T CACHING
 // When a texture is first needed,
@@ -210,72 +273,190 @@ R_DrawColumnInCache
 
 
 //
-// R_GenerateComposite
+// Composite cache.
+// Multi-patch columns are kept PU_STATIC in blocks of their own,
+//  so the zone never purges them under the refresh, and they are
+//  composited one column at a time, when first drawn.
+// The blocks stay within sysgame.kb_composites, the least recently
+//  used textures being freed first. Textures used in the current
+//  frame are never freed, the frame may go over budget instead.
+// Each block holds the composite columns, followed by one byte per
+//  texture column telling if it is built.
+//
+static int*	compositeframe;		// framecount at last use
+static int*	compositenext;		// more recently used
+static int*	compositeprev;		// less recently used
+static byte*	compositeevicted;	// freed at least once
+static int	compositehead = -1;	// most recently used
+static int	compositetail = -1;
+static int	compositebytes;
+
+compositestats_t	compositestats;
+
+
+//
+// R_EvictComposite
+//
+static void R_EvictComposite (int texnum)
+{
+    if (compositeprev[texnum] != -1)
+	compositenext[compositeprev[texnum]] = compositenext[texnum];
+    else
+	compositetail = compositenext[texnum];
+
+    if (compositenext[texnum] != -1)
+	compositeprev[compositenext[texnum]] = compositeprev[texnum];
+    else
+	compositehead = compositeprev[texnum];
+
+    compositebytes -= texturecompositesize[texnum] + textures[texnum]->width;
+
+    Z_Free (texturecomposite[texnum]);
+    texturecomposite[texnum] = NULL;
+    compositeevicted[texnum] = true;
+    compositestats.evictions++;
+}
+
+
+//
+// R_TouchComposite
+// First use of a texture in the frame,
+//  makes it the most recently used, allocating it if needed.
+//
+static void R_TouchComposite (int texnum)
+{
+    int		size;
+    byte*	block;
+
+    compositeframe[texnum] = framecount;
+
+    if (texturecomposite[texnum])
+    {
+	compositestats.hits++;
+
+	if (compositehead == texnum)
+	    return;
+
+	// unlink
+	if (compositeprev[texnum] != -1)
+	    compositenext[compositeprev[texnum]] = compositenext[texnum];
+	else
+	    compositetail = compositenext[texnum];
+	compositeprev[compositenext[texnum]] = compositeprev[texnum];
+    }
+    else
+    {
+	compositestats.misses++;
+
+	size = texturecompositesize[texnum] + textures[texnum]->width;
+
+	while (compositebytes + size > sysgame.kb_composites<<10
+	       && compositetail != -1
+	       && compositeframe[compositetail] != framecount)
+	{
+	    R_EvictComposite (compositetail);
+	}
+
+	block = Z_Malloc (size, PU_STATIC, &texturecomposite[texnum]);
+	memset (block + texturecompositesize[texnum], 0, textures[texnum]->width);
+
+	compositebytes += size;
+	if (compositebytes > compositestats.peakbytes)
+	    compositestats.peakbytes = compositebytes;
+    }
+
+    // link as most recently used
+    compositenext[texnum] = -1;
+    compositeprev[texnum] = compositehead;
+    if (compositehead != -1)
+	compositenext[compositehead] = texnum;
+    else
+	compositetail = texnum;
+    compositehead = texnum;
+}
+
+
+//
+// R_GenerateCompositeColumn
 // Using the texture definition,
-//  the composite texture is created from the patches,
-//  and each column is cached.
+//  the composite column is created from the patches.
 //
-void R_GenerateComposite (int texnum)
+static void R_GenerateCompositeColumn (int texnum, int x)
 {
-    byte*		block;
     texture_t*		texture;
     texpatch_t*		patch;	
     patch_t*		realpatch;
-    int			x;
+    column_t*		patchcol;
+    byte*		block;
     int			x1;
-    int			x2;
     int			i;
-    column_t*		patchcol;
-    short*		collump;
-    unsigned short*	colofs;
-	
-    texture = textures[texnum];
 
-    block = Z_Malloc (texturecompositesize[texnum],
-		      PU_STATIC, 
-		      &texturecomposite[texnum]);	
+    texture = textures[texnum];
+    block = texturecomposite[texnum];
 
-    collump = texturecolumnlump[texnum];
-    colofs = texturecolumnofs[texnum];
-    
-    // Composite the columns together.
-    patch = texture->patches;
-		
     for (i=0 , patch = texture->patches;
 	 i<texture->patchcount;
 	 i++, patch++)
     {
-	realpatch = W_CacheLumpNum (patch->patch, PU_CACHE);
+	realpatch = R_CacheLumpNum (patch->patch);
 	x1 = patch->originx;
-	x2 = x1 + SHORT(realpatch->width);
 
-	if (x1<0)
-	    x = 0;
-	else
-	    x = x1;
-	
-	if (x2 > texture->width)
-	    x2 = texture->width;
+	if (x < x1 || x >= x1 + SHORT(realpatch->width))
+	    continue;
 
-	for ( ; x<x2 ; x++)
-	{
-	    // Column does not have multiple patches?
-	    if (collump[x] >= 0)
-		continue;
-	    
-	    patchcol = (column_t *)((byte *)realpatch
-				    + LONG(realpatch->columnofs[x-x1]));
-	    R_DrawColumnInCache (patchcol,
-				 block + colofs[x],
-				 patch->originy,
-				 texture->height);
-	}
-						
+	patchcol = (column_t *)((byte *)realpatch
+				+ LONG(realpatch->columnofs[x-x1]));
+	R_DrawColumnInCache (patchcol,
+			     block + texturecolumnofs[texnum][x],
+			     patch->originy,
+			     texture->height);
     }
 
-    // Now that the texture has been built in column cache,
-    //  it is purgable from zone memory.
-    Z_ChangeTag (block, PU_CACHE);
+    block[texturecompositesize[texnum] + x] = 1;
+
+    compositestats.columns++;
+    if (compositeevicted[texnum])
+	compositestats.rebuilt++;
+}
+
+
+//
+// R_GenerateComposite
+// Builds all the composite columns of the texture at once.
+//
+void R_GenerateComposite (int texnum)
+{
+    byte*	built;
+    int		x;
+
+    if (compositeframe[texnum] != framecount)
+	R_TouchComposite (texnum);
+
+    built = texturecomposite[texnum] + texturecompositesize[texnum];
+
+    for (x=0 ; x<textures[texnum]->width ; x++)
+    {
+	if (texturecolumnlump[texnum][x] < 0 && !built[x])
+	    R_GenerateCompositeColumn (texnum, x);
+    }
+}
+
+
+//
+// R_PrintCompositeStats
+//
+void R_PrintCompositeStats (void)
+{
+    printf ("R_PrintCompositeStats: %i KB used, at most %i KB of %i KB,"
+	    " %i hits, %i misses, %i columns built, %i rebuilt,"
+	    " %i evictions\n",
+	    compositebytes>>10, compositestats.peakbytes>>10,
+	    sysgame.kb_composites,
+	    compositestats.hits, compositestats.misses,
+	    compositestats.columns, compositestats.rebuilt,
+	    compositestats.evictions);
+
+    memset (&compositestats, 0, sizeof(compositestats));
 }
 
 
@@ -289,6 +470,7 @@ void R_GenerateLookup (int texnum)
 	byte*		patchcount;	// patchcount[texture->width]
 	texpatch_t*		patch;	
 	patch_t*		realpatch;
+	column_t*		patchcol;
 	int			x;
 	int			x1;
 	int			x2;
@@ -329,6 +511,15 @@ void R_GenerateLookup (int texnum)
 			patchcount[x]++;
 			collump[x] = patch->patch;
 			colofs[x] = LONG(realpatch->columnofs[x-x1])+3;
+
+			// A post is at most 255 pixels, and the column
+			//  drawers can not skip holes, so a column not
+			//  covered by its first post is composited too.
+			patchcol = (column_t *)((byte *)realpatch + colofs[x] - 3);
+			if (patchcol->topdelta
+			    || patchcol->length < texture->height
+			    || ((byte *)patchcol)[patchcol->length+4] != 0xff)
+				patchcount[x]++;
 		}
 	}
 
@@ -373,15 +564,107 @@ R_GetColumn
     ofs = texturecolumnofs[tex][col];
     
     if (lump > 0)
-	return (byte *)W_CacheLumpNum(lump,PU_CACHE)+ofs;
+	return (byte *)R_CacheLumpNum(lump)+ofs;
 
-    if (!texturecomposite[tex])
-	R_GenerateComposite (tex);
+    if (compositeframe[tex] != framecount)
+	R_TouchComposite (tex);
+
+    if (!texturecomposite[tex][texturecompositesize[tex] + col])
+	R_GenerateCompositeColumn (tex, col);
 
     return texturecomposite[tex] + ofs;
 }
 
 
+//
+// R_GetMaskedColumn
+// Posts of a column, for masked mid textures.
+// Columns of a single patch are taken from the patch,
+//  even when R_GetColumn composites them.
+//
+column_t*
+R_GetMaskedColumn
+( int		tex,
+  int		col )
+{
+    texture_t*	texture;
+    texpatch_t*	patch;
+    texpatch_t*	single;
+    patch_t*	realpatch;
+    int		x1;
+    int		i;
+
+    col &= texturewidthmask[tex];
+
+    if (texturecolumnlump[tex][col] > 0)
+	return (column_t *)(R_GetColumn (tex, col) - 3);
+
+    texture = textures[tex];
+    single = NULL;
+
+    for (i=0, patch=texture->patches; i<texture->patchcount; i++, patch++)
+    {
+	realpatch = R_CacheLumpNum (patch->patch);
+	x1 = patch->originx;
+
+	if (col < x1 || col >= x1 + SHORT(realpatch->width))
+	    continue;
+
+	if (single)
+	{
+	    single = NULL;
+	    break;
+	}
+	single = patch;
+    }
+
+    if (!single)
+	return (column_t *)(R_GetColumn (tex, col) - 3);
+
+    realpatch = R_CacheLumpNum (single->patch);
+    return (column_t *)((byte *)realpatch
+			+ LONG(realpatch->columnofs[col - single->originx]));
+}
+
+
+
+//
+// R_PinTexture
+// Makes sure R_GetColumn can fetch any column of the texture
+//  without touching the zone.
+//
+void R_PinTexture (int texnum)
+{
+    texture_t*	texture;
+    int		i;
+
+    texture = textures[texnum];
+
+    // the composite is never purged, nor freed during the frame
+    if (texturecompositesize[texnum])
+	R_GenerateComposite (texnum);
+
+    for (i=0 ; i<texture->patchcount ; i++)
+	R_CacheLumpNum (texture->patches[i].patch);
+}
+
+
+//
+// R_UnpinCache
+// At the end of the frame, everything pinned is purgable again.
+//
+void R_UnpinCache (void)
+{
+    int		i;
+
+    for (i=0 ; i<numpinned ; i++)
+	Z_ChangeTag (pinned[i], PU_CACHE);
+
+    numpinned = 0;
+    r_pincache = false;
+}
+
+
 
 
 //
@@ -435,7 +718,7 @@ void R_InitTextures (void)
 		strncpy (name,name_p+i*8, 8);
 		patchlookup[i] = W_CheckNumForName (name);
 	}
-	Z_Free (names);
+	W_ReleaseLumpName ("PNAMES");
 
 	// Load the map texture definitions from textures.lmp.
 	// The data is contained in one or two lumps,
@@ -459,7 +742,6 @@ void R_InitTextures (void)
 	textures = Z_Malloc (numtextures*4, PU_STATIC, 0);
 	texturecolumnlump = Z_Malloc (numtextures*4, PU_STATIC, 0);
 	texturecolumnofs = Z_Malloc (numtextures*4, PU_STATIC, 0);
-	texturecomposite = Z_Malloc (numtextures*4, PU_STATIC, 0);
 	texturecompositesize = Z_Malloc (numtextures*4, PU_STATIC, 0);
 	texturewidthmask = Z_Malloc (numtextures*4, PU_STATIC, 0);
 	textureheight = Z_Malloc (numtextures*4, PU_STATIC, 0);
@@ -531,21 +813,46 @@ void R_InitTextures (void)
 		totalwidth += texture->width;
 	}
 
-    Z_Free (maptex1);
+    W_ReleaseLumpName ("TEXTURE1");
 	if (maptex2)
-	Z_Free (maptex2);
+	W_ReleaseLumpName ("TEXTURE2");
 
 	// Precalculate whatever possible.	
 	for (i=0 ; i<numtextures ; i++)
 		R_GenerateLookup (i);
 
-	// Create translation table for global animation.
-	texturetranslation = Z_Malloc ((numtextures+1)*4, PU_STATIC, 0);
+	Z_Free(patchlookup);
+}
 
-	for (i=0 ; i<numtextures ; i++)
-		texturetranslation[i] = i;
 
-	Z_Free(patchlookup);
+
+//
+// R_InitComposites
+// Empty composite cache, and translation table,
+//  once the textures are known.
+//
+void R_InitComposites (void)
+{
+    int		i;
+
+    texturecomposite = Z_Malloc (numtextures*4, PU_STATIC, 0);
+    compositeframe = Z_Malloc (numtextures*4, PU_STATIC, 0);
+    compositenext = Z_Malloc (numtextures*4, PU_STATIC, 0);
+    compositeprev = Z_Malloc (numtextures*4, PU_STATIC, 0);
+    compositeevicted = Z_Malloc (numtextures, PU_STATIC, 0);
+    memset (compositeevicted, 0, numtextures);
+
+    for (i=0 ; i<numtextures ; i++)
+    {
+	texturecomposite[i] = 0;
+	compositeframe[i] = -1;
+    }
+
+    // Create translation table for global animation.
+    texturetranslation = Z_Malloc ((numtextures+1)*4, PU_STATIC, 0);
+
+    for (i=0 ; i<numtextures ; i++)
+	texturetranslation[i] = i;
 }
 
 
@@ -602,6 +909,309 @@ void R_InitSpriteLumps (void)
 
 
 
+//
+// Startup tables cache.
+// The texture lookups, sprite lump sizes and sprite frames only
+//  depend on the WAD set, so they are saved after being built,
+//  and read back in one go at the next start with the same WADs.
+// The file is native, for this machine only.
+//
+#define DATACACHE_NAME		"rdcache.dat"
+#define DATACACHE_MAGIC		(('R'<<24)|('D'<<16)|('C'<<8)|'H')
+#define DATACACHE_VERSION	2
+
+#define DATACACHE_ALIGN(n)	(((n)+3) & ~3)
+#define TEXTURE_SIZE(count)	\
+	(sizeof(texture_t) + sizeof(texpatch_t)*((count)-1))
+
+typedef struct
+{
+    int		magic;
+    int		version;
+    unsigned	checksum;	// W_Checksum of the WADs
+    int		size;		// of the whole file
+    int		numtextures;
+    int		numspritelumps;
+    int		numsprites;
+    int		modifiedgame;
+
+    // Followed by, each padded to 4 bytes:
+    //  texture_t, column lumps and offsets of each texture,
+    //  texturecompositesize, texturewidthmask, textureheight,
+    //  spritewidth, spriteoffset, spritetopoffset,
+    //  sprite names, frame count of each sprite,
+    //  spriteframe_t of each sprite.
+} datacache_t;
+
+static byte*		datacache;	// the whole file, or NULL
+static datacache_t*	cacheheader;
+static byte*		cachep;		// next section
+static byte*		cacheend;
+
+
+static void R_DataCacheName (char* name)
+{
+    char*	slash;
+
+    // next to the default config file
+    strcpy (name, basedefault);
+    slash = strrchr (name, '/');
+    if (slash)
+	slash[1] = 0;
+    else
+	name[0] = 0;
+
+    strcat (name, DATACACHE_NAME);
+}
+
+
+//
+// R_ReadCached
+// Next length bytes of the cache, or NULL past its end.
+//
+static void* R_ReadCached (int length)
+{
+    byte*	p;
+
+    length = DATACACHE_ALIGN(length);
+    if (length < 0 || length > cacheend - cachep)
+	return NULL;
+
+    p = cachep;
+    cachep += length;
+    return p;
+}
+
+
+static void R_WriteCached (FILE* f, void* data, int length)
+{
+    static byte	pad[4];
+
+    fwrite (data, length, 1, f);
+    fwrite (pad, DATACACHE_ALIGN(length) - length, 1, f);
+}
+
+
+//
+// R_ReadCachedTables
+// Points the texture and sprite lump tables in the cache.
+//
+static boolean R_ReadCachedTables (void)
+{
+    texture_t*	texture;
+    int		i;
+
+    cacheheader = R_ReadCached (sizeof(datacache_t));
+
+    if (cacheheader->magic != DATACACHE_MAGIC
+	|| cacheheader->version != DATACACHE_VERSION
+	|| cacheheader->size != cacheend - datacache
+	|| cacheheader->checksum != W_Checksum ()
+	|| cacheheader->numtextures <= 0
+	|| cacheheader->numspritelumps != numspritelumps)
+	return false;
+
+    numtextures = cacheheader->numtextures;
+    textures = Z_Malloc (numtextures*4, PU_STATIC, 0);
+    texturecolumnlump = Z_Malloc (numtextures*4, PU_STATIC, 0);
+    texturecolumnofs = Z_Malloc (numtextures*4, PU_STATIC, 0);
+
+    for (i=0 ; i<numtextures ; i++)
+    {
+	texture = (texture_t *) cachep;
+	if (cacheend - cachep < (int)sizeof(texture_t)
+	    || texture->width <= 0 || texture->patchcount <= 0
+	    || !R_ReadCached (TEXTURE_SIZE(texture->patchcount)))
+	    return false;
+
+	textures[i] = texture;
+	texturecolumnlump[i] = R_ReadCached (texture->width*2);
+	texturecolumnofs[i] = R_ReadCached (texture->width*2);
+	if (!texturecolumnlump[i] || !texturecolumnofs[i])
+	    return false;
+    }
+
+    texturecompositesize = R_ReadCached (numtextures*4);
+    texturewidthmask = R_ReadCached (numtextures*4);
+    textureheight = R_ReadCached (numtextures*4);
+
+    spritewidth = R_ReadCached (numspritelumps*4);
+    spriteoffset = R_ReadCached (numspritelumps*4);
+    spritetopoffset = R_ReadCached (numspritelumps*4);
+
+    return texturecompositesize && texturewidthmask && textureheight
+	&& spritewidth && spriteoffset && spritetopoffset;
+}
+
+
+//
+// R_ReadDataCache
+// Returns false if the textures and sprite lumps
+//  must be looked at again.
+//
+boolean R_ReadDataCache (void)
+{
+    char	name[sizeof(basedefault)+sizeof(DATACACHE_NAME)];
+    FILE*	f;
+    int		length;
+
+    if (!sysgame.data_cache)
+	return false;
+
+    R_DataCacheName (name);
+    f = fopen (name, "rb");
+    if (!f)
+	return false;
+
+    fseek (f, 0, SEEK_END);
+    length = ftell (f);
+    fseek (f, 0, SEEK_SET);
+
+    if (length < (int)sizeof(datacache_t))
+    {
+	fclose (f);
+	return false;
+    }
+
+    datacache = Z_Malloc (length, PU_STATIC, NULL);
+    cachep = datacache;
+    cacheend = datacache + length;
+
+    firstspritelump = W_GetNumForName ("S_START") + 1;
+    lastspritelump = W_GetNumForName ("S_END") - 1;
+    numspritelumps = lastspritelump - firstspritelump + 1;
+
+    if (fread (datacache, length, 1, f) == 1 && R_ReadCachedTables ())
+    {
+	fclose (f);
+	return true;
+    }
+
+    fclose (f);
+
+    if (textures)
+    {
+	Z_Free (textures);
+	Z_Free (texturecolumnlump);
+	Z_Free (texturecolumnofs);
+	textures = NULL;
+    }
+    Z_Free (datacache);
+    datacache = NULL;
+    return false;
+}
+
+
+//
+// R_CachedSpriteDefs
+// Sets up sprites from the cache, if it was built
+//  for the same sprite names.
+//
+boolean R_CachedSpriteDefs (char** namelist)
+{
+    char*	names;
+    int*	numframes;
+    int		i;
+
+    if (!datacache
+	|| cacheheader->numsprites != numsprites
+	|| cacheheader->modifiedgame != (int)modifiedgame)
+	return false;
+
+    names = R_ReadCached (numsprites*4);
+    numframes = R_ReadCached (numsprites*4);
+    if (!names || !numframes)
+	return false;
+
+    for (i=0 ; i<numsprites ; i++)
+	if (strncmp (names+i*4, namelist[i], 4))
+	    return false;
+
+    sprites = Z_Malloc(numsprites *sizeof(*sprites), PU_STATIC, NULL);
+
+    for (i=0 ; i<numsprites ; i++)
+    {
+	sprites[i].numframes = numframes[i];
+	sprites[i].spriteframes =
+	    R_ReadCached (numframes[i] * sizeof(spriteframe_t));
+
+	if (numframes[i] < 0 || numframes[i] > 29
+	    || !sprites[i].spriteframes)
+	{
+	    Z_Free (sprites);
+	    return false;
+	}
+    }
+
+    return true;
+}
+
+
+//
+// R_WriteDataCache
+// Called once the sprite frames are built.
+//
+void R_WriteDataCache (char** namelist)
+{
+    char	name[sizeof(basedefault)+sizeof(DATACACHE_NAME)];
+    datacache_t	header;
+    FILE*	f;
+    int		i;
+
+    if (!sysgame.data_cache)
+	return;
+
+    R_DataCacheName (name);
+    f = fopen (name, "wb");
+    if (!f)
+	return;
+
+    memset (&header, 0, sizeof(header));
+    header.magic = DATACACHE_MAGIC;
+    header.version = DATACACHE_VERSION;
+    header.checksum = W_Checksum ();
+    header.numtextures = numtextures;
+    header.numspritelumps = numspritelumps;
+    header.numsprites = numsprites;
+    header.modifiedgame = modifiedgame;
+
+    fwrite (&header, sizeof(header), 1, f);
+
+    for (i=0 ; i<numtextures ; i++)
+    {
+	R_WriteCached (f, textures[i], TEXTURE_SIZE(textures[i]->patchcount));
+	R_WriteCached (f, texturecolumnlump[i], textures[i]->width*2);
+	R_WriteCached (f, texturecolumnofs[i], textures[i]->width*2);
+    }
+
+    fwrite (texturecompositesize, numtextures*4, 1, f);
+    fwrite (texturewidthmask, numtextures*4, 1, f);
+    fwrite (textureheight, numtextures*4, 1, f);
+
+    fwrite (spritewidth, numspritelumps*4, 1, f);
+    fwrite (spriteoffset, numspritelumps*4, 1, f);
+    fwrite (spritetopoffset, numspritelumps*4, 1, f);
+
+    for (i=0 ; i<numsprites ; i++)
+	fwrite (namelist[i], 4, 1, f);
+    for (i=0 ; i<numsprites ; i++)
+	fwrite (&sprites[i].numframes, 4, 1, f);
+    for (i=0 ; i<numsprites ; i++)
+	R_WriteCached (f, sprites[i].spriteframes,
+		sprites[i].numframes * sizeof(spriteframe_t));
+
+    header.size = ftell (f);
+    fseek (f, 0, SEEK_SET);
+    fwrite (&header, sizeof(header), 1, f);
+
+    // a partial file would only be read as out of date, but still
+    i = ferror (f);
+    if (fclose (f) || i)
+	remove (name);
+}
+
+
+
 //
 // R_InitColormaps
 //
@@ -628,12 +1238,16 @@ void R_InitColormaps (void)
 //
 void R_InitData (void)
 {
-    R_InitTextures ();
-//    printf ("\nInitTextures");
+    if (!R_ReadDataCache ())
+    {
+	R_InitTextures ();
+//	printf ("\nInitTextures");
+	R_InitSpriteLumps ();
+    }
+    R_InitComposites ();
     R_InitFlats ();
 	printf(".");
 //    printf ("\nInitFlats");
-    R_InitSpriteLumps ();
 	printf(".");
 //    printf ("\nInitSprites");
     R_InitColormaps ();
@@ -652,7 +1266,7 @@ int R_FlatNumForName (char* name)
     int		i;
     char	namet[9];
 
-    i = W_CheckNumForName (name);
+    i = W_CheckNumForNameNs (name, ns_flats);
 
     if (i == -1)
     {
@@ -30,11 +30,46 @@ R_GetColumn
 ( int		tex,
   int		col );
 
+// Posts of a column, for masked mid textures.
+column_t*
+R_GetMaskedColumn
+( int		tex,
+  int		col );
+
+
+// Zone friendly graphics access, see r_thread.c.
+extern boolean	r_pincache;
+
+void* R_CacheLumpNum (int lump);
+void R_PinTexture (int texnum);
+void R_UnpinCache (void);
+
+
+// Composite cache use, since last printed.
+typedef struct
+{
+    int		hits;		// textures found at first use in a frame
+    int		misses;		// textures allocated
+    int		columns;	// columns composited
+    int		rebuilt;	// columns composited again after eviction
+    int		evictions;
+    int		peakbytes;
+
+} compositestats_t;
+
+extern compositestats_t	compositestats;
+
+void R_PrintCompositeStats (void);
+
 
 // I/O, setting up the stuff.
 void R_InitData (void);
 void R_PrecacheLevel (void);
 
+// Startup tables saved for the next start, see r_data.c.
+boolean R_CachedSpriteDefs (char** namelist);
+void R_WriteDataCache (char** namelist);
+
 
 // Retrieval.
 // Floor/ceiling opaque texture tiles,
@@ -40,8 +40,17 @@
 #define SIL_TOP			2
 #define SIL_BOTH		3
 
+// Allocated at first, more are added when needed.
 #define MAXDRAWSEGS		256
 
+// Renderer state written while drawing a strip of the view,
+//  private to each render thread (see r_thread.c).
+#ifdef ENABLE_RENDER_THREADS
+#define R_THREADLOCAL	__thread
+#else
+#define R_THREADLOCAL
+#endif
+
 //
 // INTERNAL MAP TYPES
 //  used by play and refresh
@@ -448,6 +457,9 @@ typedef struct
   int			lightlevel;
   int			minx;
   int			maxx;
+
+  // next visplane in the same R_FindPlane hash chain, or -1
+  int			next;
   
 	unsigned short *top, *bottom;
 } visplane_t;
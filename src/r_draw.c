@@ -76,15 +76,18 @@ byte		translations[3][256];
 // R_DrawColumn
 // Source is the top of the column to scale.
 //
-lighttable_t*		dc_colormap; 
-int			dc_x; 
-int			dc_yl; 
-int			dc_yh; 
-fixed_t			dc_iscale; 
-fixed_t			dc_texturemid;
+R_THREADLOCAL lighttable_t*		dc_colormap; 
+R_THREADLOCAL int			dc_x; 
+R_THREADLOCAL int			dc_yl; 
+R_THREADLOCAL int			dc_yh; 
+R_THREADLOCAL fixed_t			dc_iscale; 
+R_THREADLOCAL fixed_t			dc_texturemid;
 
 // first pixel in a column (possibly virtual) 
-byte*			dc_source;		
+R_THREADLOCAL byte*			dc_source;		
+
+// wall texture height, for R_DrawColumnAny
+R_THREADLOCAL int			dc_texheight;
 
 // just for profiling 
 int			dccount;
@@ -95,8 +98,9 @@ int			dccount;
 //  will always have constant z depth.
 // Thus a special case loop for very fast rendering can
 //  be used. It has also been used with Wolfenstein 3D.
+// The texture wraps at 1<<heightbits rows.
 // 
-void R_DrawColumn (void) 
+static inline void R_DrawColumnBits (int heightbits)
 { 
 	unsigned short	count;
 	byte*		dest;
@@ -131,7 +135,7 @@ void R_DrawColumn (void)
 #if defined(__GNUC__) && (defined(__m68k__) && !defined(__mcoldfire__))
 
     __asm__ __volatile__ (
-	"moveql	#127,d0\n"
+	"movel	%7,d0\n"
 "	swap	%1\n"
 "	swap	%2\n"
 "	andw	d0,%2\n"
@@ -139,13 +143,13 @@ void R_DrawColumn (void)
 "	movew	%0,d2\n"	/* d2 = 3-(count&3) */
 "	notw	d2\n"
 "	andw	#3,d2\n"
-"	lea		R_DrawColumn_loop,a0\n"
-"	muluw	#R_DrawColumn_loop1-R_DrawColumn_loop,d2\n"
+"	lea		R_DrawColumn_loop%=,a0\n"
+"	muluw	#R_DrawColumn_loop1%=-R_DrawColumn_loop%=,d2\n"
 "	lsrw	#2,%0\n"
 "	move	#4,ccr\n"
 "	jmp		a0@(0,d2:w)\n"
 
-"R_DrawColumn_loop:\n"
+"R_DrawColumn_loop%=:\n"
 "	moveb	%3@(0,%2:w),d1\n"
 "	addxl	%1,%2\n"
 "	moveb	%4@(0,d1:l),d1\n"
@@ -153,7 +157,7 @@ void R_DrawColumn (void)
 "	moveb	d1,%5@\n"
 "	addw	%6,%5\n"
 
-"R_DrawColumn_loop1:\n"
+"R_DrawColumn_loop1%=:\n"
 "	moveb	%3@(0,%2:w),d1\n"
 "	addxl	%1,%2\n"
 "	moveb	%4@(0,d1:l),d1\n"
@@ -177,20 +181,21 @@ void R_DrawColumn (void)
 
 /*"	subqw	#1,%0\n"
 "	bpls	R_DrawColumn_loop"*/
-"	dbra	%0,R_DrawColumn_loop"
+"	dbra	%0,R_DrawColumn_loop%="
 	 	: /* no return value */
 	 	: /* input */
 	 		"d"(count), "d"(fracstep), "d"(frac), "a"(dc_source),
-			"a"(dc_colormap), "a"(dest), "a"(sysvideo.pitch)
+			"a"(dc_colormap), "a"(dest), "a"(sysvideo.pitch),
+			"d"((1<<heightbits)-1)
 	 	: /* clobbered registers */
-	 		"d0", "d1", "d2", "d3", "a0", "cc", "memory" 
+	 		"d0", "d1", "d2", "a0", "cc", "memory" 
 	);
 #else
 	// Re-map color indices from wall texture column
 	//  using a lighting/special effects LUT.
 
 # define RENDER_PIXEL	\
-	*dest = dc_colormap[dc_source[(frac>>FRACBITS)&127]];	\
+	*dest = dc_colormap[dc_source[(frac>>FRACBITS)&((1<<heightbits)-1)]];	\
 	dest += sysvideo.pitch; 	\
 	frac += fracstep;
 
@@ -209,7 +214,12 @@ void R_DrawColumn (void)
 #endif
 } 
 
-void R_DrawColumn060 (void) 
+void R_DrawColumn (void)
+{
+	R_DrawColumnBits (7);
+}
+
+static inline void R_DrawColumn060Bits (int heightbits)
 { 
 	int	count, rshift;
 	byte	*dest;
@@ -237,9 +247,9 @@ void R_DrawColumn060 (void)
 	fracstep = dc_iscale; 
 	frac = dc_texturemid + (dc_yl-centery)*fracstep; 
 
-	fracstep <<= 16-7;
-	frac <<= 16-7;
-	rshift = 32-7;
+	fracstep <<= 16-heightbits;
+	frac <<= 16-heightbits;
+	rshift = 32-heightbits;
 
 #if defined(__GNUC__) && (defined(__m68k__) && !defined(__mcoldfire__))
 
@@ -248,7 +258,7 @@ void R_DrawColumn060 (void)
 	"movel	%1,d0\n\t"
 	"lsrl	%2,d0\n"
 
-"R_DrawColumn060_loop:\n\t"
+"R_DrawColumn060_loop%=:\n\t"
 	"moveb	%3@(0,d0:w),d1\n\t"
 	"addl	%0,%1\n\t"
 
@@ -261,7 +271,7 @@ void R_DrawColumn060 (void)
 	"subqw	#1,%7\n\t"
 	"addal	%6,%5\n\t"
 
-	"bpls	R_DrawColumn060_loop\n"
+	"bpls	R_DrawColumn060_loop%=\n"
 
 	 	: /* no return value */
 	 	: /* input */
@@ -274,51 +284,323 @@ void R_DrawColumn060 (void)
 #endif
 } 
 
-void R_DrawColumnLow (void) 
-{ 
-	int	count, n; 
-	byte*		dest; 
-	fixed_t		frac, fracstep;	 
+void R_DrawColumn060 (void)
+{
+	R_DrawColumn060Bits (7);
+}
 
-	// Zero length.
-	if (dc_yh < dc_yl) 
-		return; 
+//
+// Wall column drawers for power of two heights,
+//  still in assembly, see R_WallColumnFunc.
+//
+static void R_DrawColumn8 (void)	{ R_DrawColumnBits (3); }
+static void R_DrawColumn16 (void)	{ R_DrawColumnBits (4); }
+static void R_DrawColumn32 (void)	{ R_DrawColumnBits (5); }
+static void R_DrawColumn64 (void)	{ R_DrawColumnBits (6); }
+static void R_DrawColumn256 (void)	{ R_DrawColumnBits (8); }
+
+static void R_DrawColumn060_8 (void)	{ R_DrawColumn060Bits (3); }
+static void R_DrawColumn060_16 (void)	{ R_DrawColumn060Bits (4); }
+static void R_DrawColumn060_32 (void)	{ R_DrawColumn060Bits (5); }
+static void R_DrawColumn060_64 (void)	{ R_DrawColumn060Bits (6); }
+static void R_DrawColumn060_256 (void)	{ R_DrawColumn060Bits (8); }
 
+//
+// Column drawers specialized by texture height, see R_WallColumnFunc.
+// R_COLUMNDRAWER wraps the texture with a power of two mask,
+//  R_COLUMNDRAWERANY with dc_texheight, for any other height.
+// Each family of drawers defines where its column starts,
+//  COLUMN_DEST, and how a pixel is written, COLUMN_PIXEL.
+//
 #ifdef RANGECHECK 
-	if ((unsigned)dc_x >= sysvideo.width
-		|| dc_yl < 0 || dc_yh >= sysvideo.height)
-		I_Error ("R_DrawColumn: %i to %i at %i", dc_yl, dc_yh, dc_x);
+#define COLUMN_RANGECHECK(name)	\
+	if ((unsigned)dc_x >= sysvideo.width	\
+		|| dc_yl < 0 || dc_yh >= sysvideo.height)	\
+		I_Error (#name ": %i to %i at %i", dc_yl, dc_yh, dc_x);
+#else
+#define COLUMN_RANGECHECK(name)
 #endif 
 
-	count = dc_yh - dc_yl; 
+#define R_COLUMNDRAWER(name, heightmask)	\
+void name (void)	\
+{	\
+	int		count, n;	\
+	byte*		dest;	\
+	fixed_t		frac, fracstep;	\
+	\
+	if (dc_yh < dc_yl)	\
+		return;	\
+	COLUMN_RANGECHECK(name)	\
+	\
+	count = dc_yh - dc_yl;	\
+	dest = COLUMN_DEST;	\
+	\
+	fracstep = dc_iscale;	\
+	frac = dc_texturemid + (dc_yl-centery)*fracstep;	\
+	\
+	n = count>>2;	\
+	switch (count & 3) {	\
+		case 3: do {	\
+				COLUMN_PIXEL((frac>>FRACBITS)&(heightmask));	\
+				frac += fracstep;	\
+		case 2:		COLUMN_PIXEL((frac>>FRACBITS)&(heightmask));	\
+				frac += fracstep;	\
+		case 1:		COLUMN_PIXEL((frac>>FRACBITS)&(heightmask));	\
+				frac += fracstep;	\
+		case 0:		COLUMN_PIXEL((frac>>FRACBITS)&(heightmask));	\
+				frac += fracstep;	\
+			} while (--n>=0);	\
+	}	\
+}
 
-	dest = ylookup[dc_yl] + columnofs[dc_x<<1];
+#define R_COLUMNDRAWERANY(name)	\
+void name (void)	\
+{	\
+	int		count;	\
+	byte*		dest;	\
+	fixed_t		frac, fracstep, height;	\
+	\
+	if (dc_yh < dc_yl)	\
+		return;	\
+	COLUMN_RANGECHECK(name)	\
+	\
+	count = dc_yh - dc_yl;	\
+	dest = COLUMN_DEST;	\
+	\
+	height = dc_texheight<<FRACBITS;	\
+	fracstep = dc_iscale % height;	\
+	frac = (dc_texturemid + (dc_yl-centery)*dc_iscale) % height;	\
+	if (frac < 0)	\
+		frac += height;	\
+	\
+	do {	\
+		COLUMN_PIXEL(frac>>FRACBITS);	\
+		frac += fracstep;	\
+		if (frac >= height)	\
+			frac -= height;	\
+	} while (--count>=0);	\
+}
 
-	fracstep = dc_iscale; 
-	frac = dc_texturemid + (dc_yl-centery)*fracstep;
-    
-	// Re-map color indices from wall texture column
-	//  using a lighting/special effects LUT.
+// Same as R_DrawColumn.
+#define COLUMN_DEST	ylookup[dc_yl] + columnofs[dc_x]
+#define COLUMN_PIXEL(texel)	\
+	*dest = dc_colormap[dc_source[texel]];	\
+	dest += sysvideo.pitch;
 
-#define RENDER_PIXEL	\
+static R_COLUMNDRAWERANY(R_DrawColumnAny)
+
+#undef COLUMN_DEST
+#undef COLUMN_PIXEL
+
+// Low detail, pixels twice as wide.
+#define COLUMN_DEST	ylookup[dc_yl] + columnofs[dc_x<<1]
+#define COLUMN_PIXEL(texel)	\
 	{	\
 		int spot;	\
-		spot = dc_colormap[dc_source[(frac>>FRACBITS)&127]];	\
+		spot = dc_colormap[dc_source[texel]];	\
 		*(unsigned short *)dest = spot|(spot<<8);	\
-		dest += sysvideo.pitch; 	\
-		frac += fracstep;	\
-	}	
+		dest += sysvideo.pitch;	\
+	}
 
-	n = count>>2;
-	switch (count & 3) {
-		case 3: do {
-				RENDER_PIXEL;
-		case 2:		RENDER_PIXEL;
-		case 1:		RENDER_PIXEL;
-		case 0:		RENDER_PIXEL;
-			} while (--n>=0);
+R_COLUMNDRAWER(R_DrawColumnLow, 127)
+static R_COLUMNDRAWER(R_DrawColumnLow8, 7)
+static R_COLUMNDRAWER(R_DrawColumnLow16, 15)
+static R_COLUMNDRAWER(R_DrawColumnLow32, 31)
+static R_COLUMNDRAWER(R_DrawColumnLow64, 63)
+static R_COLUMNDRAWER(R_DrawColumnLow256, 255)
+static R_COLUMNDRAWERANY(R_DrawColumnLowAny)
+
+#undef COLUMN_DEST
+#undef COLUMN_PIXEL
+
+//
+// R_DrawColumnQuad
+// Same pixels as R_DrawColumn, but drawn in the quad buffer of the
+//  render thread, four adjacent screen columns side by side.
+// The columns are written to the screen by R_FlushColumns,
+//  a whole row at once where the four columns are all drawn.
+// Everything drawn directly to the screen must flush first.
+//
+#define MAXQUADRANGES	8
+
+static R_THREADLOCAL int	quadbase;
+static R_THREADLOCAL int	quadcount;
+static R_THREADLOCAL int	quadnumranges[4];
+static R_THREADLOCAL short	quadranges[4][MAXQUADRANGES][2];
+
+//
+// R_QuadColumnDest
+// Adds the column to the quad buffer, returns where it starts.
+//
+static byte* R_QuadColumnDest (void)
+{
+	int	ofs, slot;
+
+	// Columns sharing the same aligned 4 bytes of a screen row.
+	ofs = columnofs[dc_x];
+	slot = ofs & 3;
+
+	if (quadcount && (quadbase != (ofs & ~3)
+		|| quadnumranges[slot] == MAXQUADRANGES))
+		R_FlushColumns ();
+
+	quadbase = ofs & ~3;
+	quadranges[slot][quadnumranges[slot]][0] = dc_yl;
+	quadranges[slot][quadnumranges[slot]][1] = dc_yh;
+	quadnumranges[slot]++;
+	quadcount++;
+
+	return rcontext->quadbuffer + (dc_yl<<2) + slot;
+}
+
+#define COLUMN_DEST	R_QuadColumnDest ()
+#define COLUMN_PIXEL(texel)	\
+	*dest = dc_colormap[dc_source[texel]];	\
+	dest += 4;
+
+R_COLUMNDRAWER(R_DrawColumnQuad, 127)
+static R_COLUMNDRAWER(R_DrawColumnQuad8, 7)
+static R_COLUMNDRAWER(R_DrawColumnQuad16, 15)
+static R_COLUMNDRAWER(R_DrawColumnQuad32, 31)
+static R_COLUMNDRAWER(R_DrawColumnQuad64, 63)
+static R_COLUMNDRAWER(R_DrawColumnQuad256, 255)
+static R_COLUMNDRAWERANY(R_DrawColumnQuadAny)
+
+#undef COLUMN_DEST
+#undef COLUMN_PIXEL
+
+//
+// R_CopyQuadColumn
+// Rows yl to yh of a single column of the quad buffer.
+//
+static void R_CopyQuadColumn (int slot, int yl, int yh)
+{
+	byte*	source;
+	int	y;
+
+	source = rcontext->quadbuffer + (yl<<2) + slot;
+
+	for (y=yl ; y<=yh ; y++, source += 4)
+		ylookup[y][quadbase+slot] = *source;
+}
+
+//
+// R_FlushColumns
+// Writes the quad buffer to the screen.
+// When all four columns have the same number of posts (walls),
+//  the rows shared by matching posts are copied 4 bytes at a time.
+//
+void R_FlushColumns (void)
+{
+	int	i, n, slot, yl, yh, top, bottom;
+	int*	source;
+
+	if (!quadcount)
+		return;
+
+	n = quadnumranges[0];
+
+	if (n && quadnumranges[1]==n && quadnumranges[2]==n && quadnumranges[3]==n) {
+		for (i=0 ; i<n ; i++) {
+			top = quadranges[0][i][0];
+			bottom = quadranges[0][i][1];
+			for (slot=1 ; slot<4 ; slot++) {
+				if (quadranges[slot][i][0] > top)
+					top = quadranges[slot][i][0];
+				if (quadranges[slot][i][1] < bottom)
+					bottom = quadranges[slot][i][1];
+			}
+
+			if (top <= bottom) {
+				source = (int *) (rcontext->quadbuffer + (top<<2));
+				for (yl=top ; yl<=bottom ; yl++)
+					*(int *) (ylookup[yl] + quadbase) = *source++;
+			}
+
+			for (slot=0 ; slot<4 ; slot++) {
+				yl = quadranges[slot][i][0];
+				yh = quadranges[slot][i][1];
+				if (top > bottom) {
+					R_CopyQuadColumn (slot, yl, yh);
+					continue;
+				}
+				if (yl < top)
+					R_CopyQuadColumn (slot, yl, top-1);
+				if (yh > bottom)
+					R_CopyQuadColumn (slot, bottom+1, yh);
+			}
+		}
+	} else {
+		for (slot=0 ; slot<4 ; slot++) {
+			for (i=0 ; i<quadnumranges[slot] ; i++)
+				R_CopyQuadColumn (slot, quadranges[slot][i][0],
+					quadranges[slot][i][1]);
+		}
 	}
-#undef RENDER_PIXEL
+
+	for (slot=0 ; slot<4 ; slot++)
+		quadnumranges[slot] = 0;
+	quadcount = 0;
+}
+
+
+//
+// R_WallColumnFunc
+// Column drawer for a wall texture of the given height,
+//  in the current detail mode.
+// Fuzz and translated columns are only used for sprites,
+//  whose posts never wrap, so they need no such variants.
+//
+static colfunc_t	highwallfuncs[6] =
+{
+	R_DrawColumn8, R_DrawColumn16, R_DrawColumn32, R_DrawColumn64,
+	R_DrawColumn256, R_DrawColumnAny
+};
+
+static colfunc_t	highwallfuncs060[6] =
+{
+	R_DrawColumn060_8, R_DrawColumn060_16, R_DrawColumn060_32,
+	R_DrawColumn060_64, R_DrawColumn060_256, R_DrawColumnAny
+};
+
+static colfunc_t	lowwallfuncs[6] =
+{
+	R_DrawColumnLow8, R_DrawColumnLow16, R_DrawColumnLow32,
+	R_DrawColumnLow64, R_DrawColumnLow256, R_DrawColumnLowAny
+};
+
+static colfunc_t	quadwallfuncs[6] =
+{
+	R_DrawColumnQuad8, R_DrawColumnQuad16, R_DrawColumnQuad32,
+	R_DrawColumnQuad64, R_DrawColumnQuad256, R_DrawColumnQuadAny
+};
+
+colfunc_t R_WallColumnFunc (int height)
+{
+	colfunc_t*	funcs;
+
+	// Same as the sprites, possibly in assembly.
+	if (height == 128)
+		return basecolfunc;
+
+	if (detailshift)
+		funcs = lowwallfuncs;
+	else if (sysvideo.quad_columns)
+		funcs = quadwallfuncs;
+	else if (sysgame.cpu060)
+		funcs = highwallfuncs060;
+	else
+		funcs = highwallfuncs;
+
+	switch (height) {
+		case 8:		return funcs[0];
+		case 16:	return funcs[1];
+		case 32:	return funcs[2];
+		case 64:	return funcs[3];
+		case 256:	return funcs[4];
+	}
+
+	return funcs[5];
 }
 
 
@@ -498,7 +780,7 @@ void R_DrawFuzzColumnLow (void)
 //  of the BaronOfHell, the HellKnight, uses
 //  identical sprites, kinda brightened up.
 //
-byte*	dc_translation;
+R_THREADLOCAL byte*	dc_translation;
 byte*	translationtables;
 
 void R_DrawTranslatedColumn (void) 
@@ -712,19 +994,19 @@ void R_InitTranslationTables (void)
 // In consequence, flats are not stored by column (like walls),
 //  and the inner loop has to step in texture space u and v.
 //
-int			ds_y; 
-int			ds_x1; 
-int			ds_x2;
+R_THREADLOCAL int			ds_y; 
+R_THREADLOCAL int			ds_x1; 
+R_THREADLOCAL int			ds_x2;
 
-lighttable_t*		ds_colormap; 
+R_THREADLOCAL lighttable_t*		ds_colormap; 
 
-fixed_t			ds_xfrac; 
-fixed_t			ds_yfrac; 
-fixed_t			ds_xstep; 
-fixed_t			ds_ystep;
+R_THREADLOCAL fixed_t			ds_xfrac; 
+R_THREADLOCAL fixed_t			ds_yfrac; 
+R_THREADLOCAL fixed_t			ds_xstep; 
+R_THREADLOCAL fixed_t			ds_ystep;
 
 // start of a 64*64 tile image 
-byte*			ds_source;	
+R_THREADLOCAL byte*			ds_source;	
 
 
 //
@@ -20,15 +20,20 @@
 #ifndef __R_DRAW__
 #define __R_DRAW__
 
-extern lighttable_t*	dc_colormap;
-extern int		dc_x;
-extern int		dc_yl;
-extern int		dc_yh;
-extern fixed_t		dc_iscale;
-extern fixed_t		dc_texturemid;
+extern R_THREADLOCAL lighttable_t*	dc_colormap;
+extern R_THREADLOCAL int		dc_x;
+extern R_THREADLOCAL int		dc_yl;
+extern R_THREADLOCAL int		dc_yh;
+extern R_THREADLOCAL fixed_t		dc_iscale;
+extern R_THREADLOCAL fixed_t		dc_texturemid;
 
 // first pixel in a column
-extern byte*		dc_source;		
+extern R_THREADLOCAL byte*		dc_source;		
+
+// wall texture height
+extern R_THREADLOCAL int		dc_texheight;
+
+typedef void (*colfunc_t) (void);
 
 
 // The span blitting interface.
@@ -38,6 +43,13 @@ void 	R_DrawColumn (void);
 void 	R_DrawColumn060 (void);
 void 	R_DrawColumnLow (void);
 
+// Draws through a buffer of 4 columns, see R_FlushColumns.
+void 	R_DrawColumnQuad (void);
+void 	R_FlushColumns (void);
+
+// Wall column drawer for a texture height, wrapping at that height.
+colfunc_t R_WallColumnFunc (int height);
+
 // The Spectre/Invisibility effect.
 void 	R_DrawFuzzColumn (void);
 void 	R_DrawFuzzColumnLow (void);
@@ -53,22 +65,22 @@ R_VideoErase
 ( int x, int y,
   int		count );
 
-extern int		ds_y;
-extern int		ds_x1;
-extern int		ds_x2;
+extern R_THREADLOCAL int		ds_y;
+extern R_THREADLOCAL int		ds_x1;
+extern R_THREADLOCAL int		ds_x2;
 
-extern lighttable_t*	ds_colormap;
+extern R_THREADLOCAL lighttable_t*	ds_colormap;
 
-extern fixed_t		ds_xfrac;
-extern fixed_t		ds_yfrac;
-extern fixed_t		ds_xstep;
-extern fixed_t		ds_ystep;
+extern R_THREADLOCAL fixed_t		ds_xfrac;
+extern R_THREADLOCAL fixed_t		ds_yfrac;
+extern R_THREADLOCAL fixed_t		ds_xstep;
+extern R_THREADLOCAL fixed_t		ds_ystep;
 
 // start of a 64*64 tile image
-extern byte*		ds_source;		
+extern R_THREADLOCAL byte*		ds_source;		
 
 extern byte*		translationtables;
-extern byte*		dc_translation;
+extern R_THREADLOCAL byte*		dc_translation;
 
 
 // Span blitting for rows, floor/ceiling.
@@ -42,5 +42,7 @@
 #include "r_data.h"
 #include "r_things.h"
 #include "r_draw.h"
+#include "r_thread.h"
+#include "r_pvs.h"
 
 #endif		// __R_LOCAL__
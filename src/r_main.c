@@ -22,12 +22,14 @@
 #include <stdlib.h>
 #include <math.h>
 #include <stdio.h>
+#include <string.h>
 
 
 #include "doomdef.h"
 #include "d_net.h"
 
 #include "m_bbox.h"
+#include "m_prof.h"
 
 #include "r_local.h"
 #include "r_sky.h"
@@ -49,7 +51,7 @@ int			validcount = 1;
 
 
 lighttable_t*		fixedcolormap;
-extern lighttable_t**	walllights;
+extern R_THREADLOCAL lighttable_t**	walllights;
 
 int			centerx;
 int			centery;
@@ -115,7 +117,7 @@ int			extralight;
 
 
 
-void (*colfunc) (void);
+R_THREADLOCAL void (*colfunc) (void);
 void (*basecolfunc) (void);
 void (*fuzzcolfunc) (void);
 void (*transcolfunc) (void);
@@ -694,7 +696,9 @@ void R_ExecuteSetViewSize (void)
 	projection = centerxfrac;
 
 	if (!detailshift) {
-		if (sysgame.cpu060) {
+		if (sysvideo.quad_columns) {
+			colfunc = basecolfunc = R_DrawColumnQuad;
+		} else if (sysgame.cpu060) {
 			colfunc = basecolfunc = R_DrawColumn060;
 		} else {
 			colfunc = basecolfunc = R_DrawColumn;
@@ -779,6 +783,7 @@ extern int	screenblocks;
 
 void R_Init (void)
 {
+    R_InitRenderThreads ();
     R_InitData ();
 //    printf ("\nR_InitData");
     R_InitPointToAngle ();
@@ -876,6 +881,66 @@ void R_SetupFrame (player_t* player)
 
 
 
+//
+// R_CountFrame
+// Keeps the highest use of the growable arrays.
+//
+renderstats_t	renderstats;
+static renderstats_t	renderpeaks;
+
+static void R_CountFrame (void)
+{
+    if (renderstats.visplanes > renderpeaks.visplanes)
+	renderpeaks.visplanes = renderstats.visplanes;
+    if (renderstats.drawsegs > renderpeaks.drawsegs)
+	renderpeaks.drawsegs = renderstats.drawsegs;
+    if (renderstats.vissprites > renderpeaks.vissprites)
+	renderpeaks.vissprites = renderstats.vissprites;
+    if (renderstats.openings > renderpeaks.openings)
+	renderpeaks.openings = renderstats.openings;
+    if (renderstats.planeprobes > renderpeaks.planeprobes)
+	renderpeaks.planeprobes = renderstats.planeprobes;
+    if (renderstats.bspnodes > renderpeaks.bspnodes)
+	renderpeaks.bspnodes = renderstats.bspnodes;
+    if (renderstats.pvsskipped > renderpeaks.pvsskipped)
+	renderpeaks.pvsskipped = renderstats.pvsskipped;
+}
+
+
+//
+// R_PrintRenderStats
+//
+void R_PrintRenderStats (void)
+{
+    if (!renderpeaks.visplanes)
+	return;
+
+    printf ("R_PrintRenderStats: at most %i visplanes, %i drawsegs,"
+	    " %i vissprites, %i openings, %i visplane probes,"
+	    " %i BSP nodes visited, %i skipped by PVS\n",
+	    renderpeaks.visplanes, renderpeaks.drawsegs,
+	    renderpeaks.vissprites, renderpeaks.openings,
+	    renderpeaks.planeprobes, renderpeaks.bspnodes,
+	    renderpeaks.pvsskipped);
+
+    memset (&renderpeaks, 0, sizeof(renderpeaks));
+}
+
+
+
+//
+// R_DrawStrip
+// Walls queued while the BSP was traversed,
+//  then floors and ceilings.
+//
+static void R_DrawStrip (void)
+{
+    R_DrawQueuedColumns ();
+    R_DrawPlanes ();
+}
+
+
+
 //
 // R_RenderView
 //
@@ -888,22 +953,41 @@ void R_RenderPlayerView (player_t* player)
     R_ClearDrawSegs ();
     R_ClearPlanes ();
     R_ClearSprites ();
+    R_StartStrips ();
     
     // check for new console commands.
     NetUpdate ();
 
     // The head node is the last node output.
+    M_ProfBegin (prof_bsp);
+    R_SetupPVS ();
+    renderstats.bspnodes = 0;
+    renderstats.pvsskipped = 0;
     R_RenderBSPNode (numnodes-1);
+    R_FlushColumns ();
+    M_ProfEnd (prof_bsp);
     
     // Check for new console commands.
     NetUpdate ();
     
-    R_DrawPlanes ();
+    M_ProfBegin (prof_planes);
+    R_PrepPlanes ();
+    R_RunStrips (R_DrawStrip);
+    M_ProfEnd (prof_planes);
     
     // Check for new console commands.
     NetUpdate ();
     
-    R_DrawMasked ();
+    M_ProfBegin (prof_masked);
+    if (R_PrepMasked ())
+	R_RunStrips (R_DrawMasked);
+    else
+	R_RunView (R_DrawMasked);
+    M_ProfEnd (prof_masked);
+
+    R_CountFrame ();
+
+    R_FinishStrips ();
 
     // Check for new console commands.
     NetUpdate ();				
@@ -45,6 +45,9 @@ extern fixed_t		projection;
 
 extern int		validcount;
 
+// Incremented for every frame drawn.
+extern int		framecount;
+
 extern int		linecount;
 extern int		loopcount;
 
@@ -88,7 +91,7 @@ extern	int		detailshift;
 // Function pointers to switch refresh/drawing functions.
 // Used to select shadow mode etc.
 //
-extern void		(*colfunc) (void);
+extern R_THREADLOCAL void	(*colfunc) (void);
 extern void		(*basecolfunc) (void);
 extern void		(*transcolfunc) (void);
 extern void		(*fuzzcolfunc) (void);
@@ -96,6 +99,30 @@ extern void		(*fuzzcolfunc) (void);
 extern void		(*spanfunc) (void);
 
 
+//
+// Use of the renderer arrays that grow on demand.
+//
+typedef struct
+{
+    int		visplanes;
+    int		drawsegs;
+    int		vissprites;
+    int		openings;
+
+    // visplanes compared by R_FindPlane
+    int		planeprobes;
+
+    // nodes and subsectors visited by R_RenderBSPNode,
+    //  and subtrees it skipped for the PVS
+    int		bspnodes;
+    int		pvsskipped;
+
+} renderstats_t;
+
+// for the last frame, set by R_PrepPlanes and R_PrepMasked
+extern renderstats_t	renderstats;
+
+
 //
 // Utility functions.
 int
@@ -158,4 +185,7 @@ void R_SetViewSize (int blocks, int detail);
 
 void R_ExecuteSetViewSize(void);
 
+// Prints the highest use since the last call.
+void R_PrintRenderStats (void);
+
 #endif
@@ -44,17 +44,34 @@ planefunction_t		ceilingfunc;
 //
 
 // Here comes the obnoxious "visplane".
+// Allocated at first, doubled when all are used.
 #define MAXVISPLANES	128
-static visplane_t		visplanes[MAXVISPLANES];
+static visplane_t		*visplanes=NULL;
 static visplane_t*		lastvisplane;
+static int			maxvisplanes=MAXVISPLANES;
 visplane_t*		floorplane;
 visplane_t*		ceilingplane;
 
+// top and bottom of all visplanes
 static unsigned short *visplanesy;
 
-// ?
+// R_FindPlane hash chains, as indexes in visplanes.
+// Only the visplanes made by R_FindPlane are in there,
+//  so the first one of a kind is still the one found.
+#define VISPLANEHASHSIZE	128
+static int			visplanehash[VISPLANEHASHSIZE];
+static int			planeprobes;
+
+#define VISPLANEHASH(height,picnum,lightlevel) \
+	(((height)>>FRACBITS)*7 + (picnum)*3 + (lightlevel)) & (VISPLANEHASHSIZE-1)
+
+// Openings are taken from blocks of MAXOPENINGS,
+//  one more is added when they are all used.
 #define MAXOPENINGS	(sysvideo.width*64)
-static short			*openings=NULL;
+static short			**openingblocks=NULL;
+static int			numopeningblocks;
+static int			openingblock;
+static short*			openingsend;
 short*			lastopening;
 
 
@@ -69,26 +86,21 @@ short			*ceilingclip=NULL;
 //
 // spanstart holds the start of a plane span
 // initialized to 0 at start
+// It lives in the rendercontext_t, along with
+//  the cached row values, one per render thread.
 //
-static int			*spanstart=NULL;
-static int			*spanstop=NULL;
 
 //
 // texture mapping
 //
-lighttable_t**		planezlight;
-fixed_t			planeheight;
+static R_THREADLOCAL lighttable_t**	planezlight;
+static R_THREADLOCAL fixed_t		planeheight;
 
 fixed_t			*yslope=NULL;
 fixed_t			*distscale=NULL;
 fixed_t			basexscale;
 fixed_t			baseyscale;
 
-fixed_t			*cachedheight=NULL;
-fixed_t			*cacheddistance=NULL;
-fixed_t			*cachedxstep=NULL;
-fixed_t			*cachedystep=NULL;
-
 
 
 //
@@ -102,33 +114,117 @@ fixed_t			*cachedystep=NULL;
 	\
 	pointer = Z_Malloc(sizeof(type)*size, PU_STATIC, NULL);
 
+//
+// R_SetupVisplanes
+// Points each visplane to its top and bottom in visplanesy.
+//
+static void R_SetupVisplanes (void)
+{
+	int i;
+	unsigned short *array;
+
+	array = &visplanesy[1];
+	for (i=0;i<maxvisplanes;i++) {
+		visplanes[i].top = array;
+		array += sysvideo.width+2;
+		visplanes[i].bottom = array;
+		array += sysvideo.width+2;
+	}
+}
+
+//
+// R_GrowVisplanes
+// Doubles the visplanes, keeping the ones in use.
+//
+static void R_GrowVisplanes (void)
+{
+	visplane_t*	newvisplanes;
+	unsigned short*	newvisplanesy;
+	int		numvisplanes;
+	int		planesize;
+
+	numvisplanes = lastvisplane - visplanes;
+	planesize = (sysvideo.width+2)<<1;
+
+	newvisplanes = Z_Malloc(sizeof(visplane_t)*maxvisplanes*2, PU_STATIC, NULL);
+	memcpy(newvisplanes, visplanes, sizeof(visplane_t)*numvisplanes);
+
+	newvisplanesy = Z_Malloc(sizeof(unsigned short)*planesize*maxvisplanes*2, PU_STATIC, NULL);
+	memcpy(newvisplanesy, visplanesy, sizeof(unsigned short)*planesize*numvisplanes);
+
+	// the BSP traversal may hold these
+	if (floorplane)
+		floorplane = newvisplanes + (floorplane - visplanes);
+	if (ceilingplane)
+		ceilingplane = newvisplanes + (ceilingplane - visplanes);
+
+	Z_Free(visplanes);
+	Z_Free(visplanesy);
+
+	visplanes = newvisplanes;
+	visplanesy = newvisplanesy;
+	lastvisplane = visplanes + numvisplanes;
+	maxvisplanes *= 2;
+
+	R_SetupVisplanes ();
+}
+
+//
+// R_AddOpeningBlock
+//
+static void R_AddOpeningBlock (void)
+{
+	short**	newblocks;
+
+	newblocks = Z_Malloc(sizeof(short *)*(numopeningblocks+1), PU_STATIC, NULL);
+	if (openingblocks) {
+		memcpy(newblocks, openingblocks, sizeof(short *)*numopeningblocks);
+		Z_Free(openingblocks);
+	}
+	openingblocks = newblocks;
+
+	openingblocks[numopeningblocks++] = Z_Malloc(sizeof(short)*MAXOPENINGS, PU_STATIC, NULL);
+}
+
 void R_InitPlanes (void)
 {
-	ALLOCATE_ARRAY(openings, MAXOPENINGS, short);
+	int i;
+
 	ALLOCATE_ARRAY(floorclip, sysvideo.width, short);
 	ALLOCATE_ARRAY(ceilingclip, sysvideo.width, short);
-	ALLOCATE_ARRAY(spanstart, sysvideo.height, int);
-	ALLOCATE_ARRAY(spanstop, sysvideo.height, int);
 	ALLOCATE_ARRAY(yslope, sysvideo.height, fixed_t);
 	ALLOCATE_ARRAY(distscale, sysvideo.width, fixed_t);
-	ALLOCATE_ARRAY(cachedheight, sysvideo.height, fixed_t);
-	ALLOCATE_ARRAY(cacheddistance, sysvideo.height, fixed_t);
-	ALLOCATE_ARRAY(cachedxstep, sysvideo.height, fixed_t);
-	ALLOCATE_ARRAY(cachedystep, sysvideo.height, fixed_t);
-	ALLOCATE_ARRAY(visplanesy, ((sysvideo.width+2)<<1)*MAXVISPLANES, unsigned short);
-
-	{
-		int i;
-		unsigned short *array;
-
-		array = &visplanesy[1];
-		for (i=0;i<MAXVISPLANES;i++) {
-			visplanes[i].top = array;
-			array += sysvideo.width+2;
-			visplanes[i].bottom = array;
-			array += sysvideo.width+2;
-		}
-	}
+	ALLOCATE_ARRAY(visplanes, maxvisplanes, visplane_t);
+	ALLOCATE_ARRAY(visplanesy, ((sysvideo.width+2)<<1)*maxvisplanes, unsigned short);
+
+	R_SetupVisplanes ();
+
+	// MAXOPENINGS depends on the width
+	for (i=0;i<numopeningblocks;i++)
+		Z_Free(openingblocks[i]);
+	numopeningblocks = 0;
+
+	R_AddOpeningBlock ();
+
+	R_InitRenderContexts ();
+}
+
+
+//
+// R_CheckOpenings
+// Makes room for count openings, in the next block if needed.
+// The openings in use stay where they are, drawsegs point to them.
+//
+void R_CheckOpenings (int count)
+{
+	if (lastopening + count <= openingsend)
+		return;
+
+	if (++openingblock == numopeningblocks)
+		R_AddOpeningBlock ();
+
+	lastopening = openingblocks[openingblock];
+	openingsend = lastopening + MAXOPENINGS;
 }
 
 
@@ -142,6 +238,8 @@ void R_InitPlanes (void)
 //  baseyscale
 //  viewx
 //  viewy
+// Spans are clipped to the strip of the
+//  current render thread.
 //
 // BASIC PRIMITIVE
 //
@@ -155,6 +253,10 @@ R_MapPlane
     fixed_t	distance;
     fixed_t	length;
     unsigned	index;
+    fixed_t*	cachedheight;
+    fixed_t*	cacheddistance;
+    fixed_t*	cachedxstep;
+    fixed_t*	cachedystep;
 	
 #ifdef RANGECHECK
     if (x2 < x1
@@ -166,6 +268,14 @@ R_MapPlane
     }
 #endif
 
+    if (x2 < rcontext->x1 || x1 > rcontext->x2)
+	return;
+
+    cachedheight = rcontext->cachedheight;
+    cacheddistance = rcontext->cacheddistance;
+    cachedxstep = rcontext->cachedxstep;
+    cachedystep = rcontext->cachedystep;
+
     if (planeheight != cachedheight[y])
     {
 	cachedheight[y] = planeheight;
@@ -185,6 +295,16 @@ R_MapPlane
     ds_xfrac = viewx + FixedMul(finecosine[angle], length);
     ds_yfrac = -viewy - FixedMul(finesine[angle], length);
 
+    // step to the strip, as the span drawer would have
+    if (x1 < rcontext->x1)
+    {
+	ds_xfrac += (rcontext->x1 - x1)*ds_xstep;
+	ds_yfrac += (rcontext->x1 - x1)*ds_ystep;
+	x1 = rcontext->x1;
+    }
+    if (x2 > rcontext->x2)
+	x2 = rcontext->x2;
+
     if (fixedcolormap)
 	ds_colormap = fixedcolormap;
     else
@@ -222,10 +342,14 @@ void R_ClearPlanes (void)
 	}
 
 	lastvisplane = visplanes;
-	lastopening = openings;
 
-	// texture calculation
-	memset (cachedheight, 0, sizeof(fixed_t)*sysvideo.height);
+	for (i=0 ; i<VISPLANEHASHSIZE ; i++)
+		visplanehash[i] = -1;
+	planeprobes = 0;
+
+	openingblock = 0;
+	lastopening = openingblocks[0];
+	openingsend = lastopening + MAXOPENINGS;
 
 	// left to right mapping
 	angle = (viewangle-ANG90)>>ANGLETOFINESHIFT;
@@ -248,28 +372,35 @@ R_FindPlane
   int		lightlevel )
 {
 	visplane_t*	check;
+	int		hash;
+	int		i;
 
 	if (picnum == skyflatnum) {
 		height = 0;			// all skys map together
 		lightlevel = 0;
 	}
 
-	for (check=visplanes; check<lastvisplane; check++) {
+	hash = VISPLANEHASH(height, picnum, lightlevel);
+
+	for (i=visplanehash[hash]; i != -1; i=check->next) {
+		check = &visplanes[i];
+		planeprobes++;
+
 		if (height == check->height
 			&& picnum == check->picnum
 			&& lightlevel == check->lightlevel)
 		{
-			break;
+			return check;
 		}
 	}
-			
-	if (check < lastvisplane)
-		return check;
 
-	if (lastvisplane - visplanes == MAXVISPLANES)
-		I_Error ("R_FindPlane: no more visplanes");
+	if (lastvisplane - visplanes == maxvisplanes)
+		R_GrowVisplanes ();
+
+	check = lastvisplane++;
 
-	lastvisplane++;
+	check->next = visplanehash[hash];
+	visplanehash[hash] = check - visplanes;
 
 	check->height = height;
 	check->picnum = picnum;
@@ -298,6 +429,7 @@ R_CheckPlane
 	int		unionl;
 	int		unionh;
 	int		x;
+	int		index;
 
 	if (start < pl->minx) {
 		intrl = pl->minx;
@@ -328,6 +460,12 @@ R_CheckPlane
 	}
 
 	// make a new visplane
+	if (lastvisplane - visplanes == maxvisplanes) {
+		index = pl - visplanes;
+		R_GrowVisplanes ();
+		pl = visplanes + index;
+	}
+
 	lastvisplane->height = pl->height;
 	lastvisplane->picnum = pl->picnum;
 	lastvisplane->lightlevel = pl->lightlevel;
@@ -354,6 +492,8 @@ R_MakeSpans
   int		t2,
   int		b2 )
 {
+	int*	spanstart = rcontext->spanstart;
+
 	while (t1 < t2 && t1<=b1) {
 		R_MapPlane (t1,spanstart[t1],x-1);
 		t1++;
@@ -375,33 +515,66 @@ R_MakeSpans
 
 
 
+//
+// R_PrepPlanes
+// At the end of the BSP traversal, before
+//  the planes are drawn by each render thread.
+//
+void R_PrepPlanes (void)
+{
+	visplane_t*		pl;
+
+	renderstats.visplanes = lastvisplane - visplanes;
+	renderstats.drawsegs = ds_p - drawsegs;
+	renderstats.openings = openingblock*MAXOPENINGS
+		+ (lastopening - openingblocks[openingblock]);
+	renderstats.planeprobes = planeprobes;
+
+	for (pl = visplanes ; pl < lastvisplane ; pl++) {
+		if (pl->minx > pl->maxx)
+			continue;
+
+		if (pl->picnum == skyflatnum) {
+			if (r_pincache)
+				R_PinTexture (skytexture);
+			continue;
+		}
+
+		if (r_pincache)
+			R_CacheLumpNum (firstflat + flattranslation[pl->picnum]);
+
+		pl->top[pl->maxx+1] = 0xffff;
+		pl->bottom[pl->maxx+1] = 0;
+		pl->top[pl->minx-1] = 0xffff;
+		pl->bottom[pl->minx-1] = 0;
+	}
+}
+
+
 //
 // R_DrawPlanes
 // At the end of each frame.
+// Only draws the strip of the current render thread.
 //
 void R_DrawPlanes (void)
 {
 	visplane_t*		pl;
 	int			light;
 	int			x;
+	int			start;
 	int			stop;
 	int			angle;
+	colfunc_t		skyfunc;
 
-#ifdef RANGECHECK
-	if (ds_p - drawsegs > MAXDRAWSEGS)
-		I_Error ("R_DrawPlanes: drawsegs overflow (%i)", ds_p - drawsegs);
-
-	if (lastvisplane - visplanes > MAXVISPLANES)
-		I_Error ("R_DrawPlanes: visplane overflow (%i)", lastvisplane - visplanes);
-
-	if (lastopening - openings > MAXOPENINGS)
-		I_Error ("R_DrawPlanes: opening overflow (%i)", lastopening - openings);
-#endif
+	// texture calculation
+	memset (rcontext->cachedheight, 0, sizeof(fixed_t)*sysvideo.height);
 
 	for (pl = visplanes ; pl < lastvisplane ; pl++) {
 		if (pl->minx > pl->maxx)
 			continue;
 
+		if (pl->minx > rcontext->x2 || pl->maxx < rcontext->x1)
+			continue;
 
 		// sky flat
 		if (pl->picnum == skyflatnum) {
@@ -414,7 +587,13 @@ void R_DrawPlanes (void)
 			//  by INVUL inverse mapping.
 			dc_colormap = colormaps;
 			dc_texturemid = skytexturemid;
-			for (x=pl->minx ; x <= pl->maxx ; x++) {
+			dc_texheight = textureheight[skytexture]>>FRACBITS;
+			skyfunc = R_WallColumnFunc (dc_texheight);
+
+			start = pl->minx < rcontext->x1 ? rcontext->x1 : pl->minx;
+			stop = pl->maxx > rcontext->x2 ? rcontext->x2 : pl->maxx;
+
+			for (x=start ; x <= stop ; x++) {
 				dc_yl = pl->top[x];
 				dc_yh = pl->bottom[x];
 
@@ -422,15 +601,16 @@ void R_DrawPlanes (void)
 					angle = (viewangle + xtoviewangle[x])>>ANGLETOSKYSHIFT;
 					dc_x = x;
 					dc_source = R_GetColumn(skytexture, angle);
-					colfunc ();
+					skyfunc ();
 				}
 			}
+			R_FlushColumns ();
 			continue;
 		}
 
 		// regular flat
-		ds_source = W_CacheLumpNum(firstflat +
-			flattranslation[pl->picnum], PU_STATIC);
+		ds_source = R_CacheLumpNum(firstflat +
+			flattranslation[pl->picnum]);
 
 		planeheight = abs(pl->height-viewz);
 		light = (pl->lightlevel >> LIGHTSEGSHIFT)+extralight;
@@ -442,11 +622,7 @@ void R_DrawPlanes (void)
 
 		planezlight = zlight[light];
 
-		pl->top[pl->maxx+1] = 0xffff;
-		pl->bottom[pl->maxx+1] = 0;
-		pl->top[pl->minx-1] = 0xffff;
-		pl->bottom[pl->minx-1] = 0;
-		
+		// spans are clipped by R_MapPlane
 		stop = pl->maxx + 1;
 
 		for (x=pl->minx ; x<= stop ; x++) {
@@ -455,7 +631,5 @@ void R_DrawPlanes (void)
 				pl->top[x], pl->bottom[x]
 			);
 		}
-
-		Z_ChangeTag (ds_source, PU_CACHE);
     }
 }
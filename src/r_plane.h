@@ -25,6 +25,8 @@
 // Visplane related.
 extern  short*		lastopening;
 
+void R_CheckOpenings (int count);
+
 
 typedef void (*planefunction_t) (int top, int bottom);
 
@@ -54,6 +56,7 @@ R_MakeSpans
   int		t2,
   int		b2 );
 
+void R_PrepPlanes (void);
 void R_DrawPlanes (void);
 
 visplane_t*
@@ -0,0 +1,437 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// Copyright (C) 1993-1996 by id Software, Inc.
+//
+// This source is available for distribution and/or modification
+// only under the terms of the DOOM Source Code License as
+// published by id Software. All rights reserved.
+//
+// The source is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// FITNESS FOR A PARTICULAR PURPOSE. See the DOOM Source Code License
+// for more details.
+//
+// DESCRIPTION:
+//	Potentially visible set, built at level setup.
+//	Two sided lines are portals between sectors. A sector may be
+//	 seen from another one if a straight line goes from one to
+//	 the other through a chain of portals, found by clipping each
+//	 next portal to what can be seen through the previous ones.
+//	Heights, and doors, are not looked at: a closed door is still
+//	 an open portal.
+//	The BSP traversal then skips the subtrees without any sector
+//	 visible from the view sector.
+//
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "doomdef.h"
+#include "doomstat.h"
+
+#include "i_system.h"
+#include "i_video.h"
+#include "z_zone.h"
+
+#include "r_local.h"
+#include "r_state.h"
+#include "r_pvs.h"
+
+
+// Bigger maps are drawn without PVS, it takes numsectors^2 bits.
+#define PVS_MAXSECTORS		4096
+
+// Portals flowed through from one sector, before giving up
+//  and seeing everything from there.
+#define PVS_MAXFLOWS		100000
+
+// Portals flowed through in a row, also seeing everything past it,
+//  the stack is small on the Atari.
+#define PVS_MAXDEPTH		64
+
+// Map units.
+#define PVS_EPSILON		(1.0/16)
+
+
+typedef struct
+{
+    double	x1;
+    double	y1;
+    double	x2;
+    double	y2;
+
+} pvsseg_t;
+
+// A portal, the sector it leads to is on the left.
+typedef struct
+{
+    pvsseg_t	seg;
+    int		to;
+
+} pvsportal_t;
+
+static pvsportal_t*	portals;
+static int*		firstportal;	// [numsectors+1]
+
+static byte*		pvs;		// [numsectors][pvsrowbytes]
+static int		pvsrowbytes;
+static byte*		pvsrow;
+static int		pvsflows;
+static sector_t*	pvssector;	// of pvsnodes
+
+byte*			pvsnodes;
+byte*			pvssubsectors;
+
+
+//
+// R_PVSDist
+// Distance of the point on the left of line, negative on its right.
+//
+static double R_PVSDist (pvsseg_t* line, double x, double y)
+{
+    double	dx;
+    double	dy;
+
+    dx = line->x2 - line->x1;
+    dy = line->y2 - line->y1;
+
+    return (dx*(y - line->y1) - dy*(x - line->x1)) / sqrt (dx*dx + dy*dy);
+}
+
+
+//
+// R_ClipPVSSeg
+// Keeps the part of seg on the left of line, or on its right
+//  if side is -1. Returns false if nothing is left off the line.
+//
+static boolean R_ClipPVSSeg (pvsseg_t* seg, pvsseg_t* line, double side)
+{
+    double	d1;
+    double	d2;
+    double	frac;
+
+    d1 = side * R_PVSDist (line, seg->x1, seg->y1);
+    d2 = side * R_PVSDist (line, seg->x2, seg->y2);
+
+    if (d1 <= PVS_EPSILON && d2 <= PVS_EPSILON)
+	return false;
+
+    if (d1 < 0)
+    {
+	frac = d1 / (d1 - d2);
+	seg->x1 += (seg->x2 - seg->x1) * frac;
+	seg->y1 += (seg->y2 - seg->y1) * frac;
+    }
+    else if (d2 < 0)
+    {
+	frac = d2 / (d2 - d1);
+	seg->x2 += (seg->x1 - seg->x2) * frac;
+	seg->y2 += (seg->y1 - seg->y2) * frac;
+    }
+
+    return true;
+}
+
+
+//
+// R_ClipSeparators
+// Clips target to what can be seen from source through pass.
+// A line through an end of source and an end of pass, with
+//  source and pass on both sides, is a separator: the target
+//  must be on the side of pass.
+//
+static boolean
+R_ClipSeparators
+( pvsseg_t*	source,
+  pvsseg_t*	pass,
+  pvsseg_t*	target )
+{
+    double	sx[2];
+    double	sy[2];
+    double	px[2];
+    double	py[2];
+    pvsseg_t	line;
+    double	ds;
+    double	dp;
+    int		i;
+    int		j;
+
+    sx[0] = source->x1;	sy[0] = source->y1;
+    sx[1] = source->x2;	sy[1] = source->y2;
+    px[0] = pass->x1;	py[0] = pass->y1;
+    px[1] = pass->x2;	py[1] = pass->y2;
+
+    for (i=0 ; i<2 ; i++)
+    {
+	for (j=0 ; j<2 ; j++)
+	{
+	    line.x1 = sx[i];
+	    line.y1 = sy[i];
+	    line.x2 = px[j];
+	    line.y2 = py[j];
+
+	    // portals sharing a vertex
+	    if (fabs (line.x2 - line.x1) + fabs (line.y2 - line.y1) < PVS_EPSILON)
+		continue;
+
+	    ds = R_PVSDist (&line, sx[i^1], sy[i^1]);
+	    dp = R_PVSDist (&line, px[j^1], py[j^1]);
+
+	    if (ds < -PVS_EPSILON && dp > PVS_EPSILON)
+	    {
+		if (!R_ClipPVSSeg (target, &line, 1))
+		    return false;
+	    }
+	    else if (ds > PVS_EPSILON && dp < -PVS_EPSILON)
+	    {
+		if (!R_ClipPVSSeg (target, &line, -1))
+		    return false;
+	    }
+	}
+    }
+
+    return true;
+}
+
+
+//
+// R_FlowPVS
+// Marks the sectors seen from source through pass,
+//  the portal into sector, depth portals away.
+//
+static void
+R_FlowPVS
+( pvsseg_t*	source,
+  pvsseg_t*	pass,
+  int		sector,
+  int		depth )
+{
+    pvsportal_t*	portal;
+    pvsportal_t*	end;
+    pvsseg_t		target;
+    pvsseg_t		newsource;
+
+    if (++pvsflows > PVS_MAXFLOWS)
+	return;
+
+    // Give up like with too many flows.
+    if (depth > PVS_MAXDEPTH)
+    {
+	pvsflows = PVS_MAXFLOWS+1;
+	return;
+    }
+
+    end = &portals[firstportal[sector+1]];
+
+    for (portal = &portals[firstportal[sector]] ; portal < end ; portal++)
+    {
+	// Must be beyond the source and the pass.
+	target = portal->seg;
+	if (!R_ClipPVSSeg (&target, source, 1))
+	    continue;
+	if (pass != source && !R_ClipPVSSeg (&target, pass, 1))
+	    continue;
+
+	// Only the source behind the target can see through it.
+	newsource = *source;
+	if (!R_ClipPVSSeg (&newsource, &portal->seg, -1))
+	    continue;
+
+	if (pass != source
+	    && !R_ClipSeparators (&newsource, pass, &target))
+	    continue;
+
+	pvsrow[portal->to>>3] |= 1<<(portal->to&7);
+	R_FlowPVS (&newsource, &target, portal->to, depth+1);
+    }
+}
+
+
+//
+// R_AddPortal
+//
+static void
+R_AddPortal
+( int		from,
+  int		to,
+  vertex_t*	v1,
+  vertex_t*	v2,
+  int*		next )
+{
+    pvsportal_t*	portal;
+
+    portal = &portals[next[from]++];
+    portal->seg.x1 = (double)v1->x / FRACUNIT;
+    portal->seg.y1 = (double)v1->y / FRACUNIT;
+    portal->seg.x2 = (double)v2->x / FRACUNIT;
+    portal->seg.y2 = (double)v2->y / FRACUNIT;
+    portal->to = to;
+}
+
+
+//
+// R_BuildPVS
+// Called by P_SetupLevel, after P_GroupLines.
+//
+void R_BuildPVS (void)
+{
+    line_t*	line;
+    int*	next;
+    int		numportals;
+    int		front;
+    int		back;
+    int		overflows;
+    int		visible;
+    int		i;
+    int		j;
+
+    pvs = NULL;
+    pvsnodes = NULL;
+    pvssubsectors = NULL;
+    pvssector = NULL;
+
+    if (!sysvideo.pvs)
+	return;
+
+    if (numsectors > PVS_MAXSECTORS)
+    {
+	printf ("R_BuildPVS: %i sectors, drawing without PVS\n", numsectors);
+	return;
+    }
+
+    // Two portals for each line between two sectors,
+    //  grouped by the sector they leave.
+    firstportal = Z_Malloc ((numsectors+1)*sizeof(int), PU_STATIC, NULL);
+    next = Z_Malloc ((numsectors+1)*sizeof(int), PU_STATIC, NULL);
+    memset (firstportal, 0, (numsectors+1)*sizeof(int));
+
+    numportals = 0;
+    for (i=0, line=lines ; i<numlines ; i++, line++)
+    {
+	if (!line->backsector || line->backsector == line->frontsector)
+	    continue;
+
+	firstportal[line->frontsector - sectors + 1]++;
+	firstportal[line->backsector - sectors + 1]++;
+	numportals += 2;
+    }
+
+    for (i=0 ; i<numsectors ; i++)
+    {
+	firstportal[i+1] += firstportal[i];
+	next[i] = firstportal[i];
+    }
+
+    portals = Z_Malloc ((numportals+1)*sizeof(pvsportal_t), PU_STATIC, NULL);
+
+    for (i=0, line=lines ; i<numlines ; i++, line++)
+    {
+	if (!line->backsector || line->backsector == line->frontsector)
+	    continue;
+
+	// the back side is on the left
+	front = line->frontsector - sectors;
+	back = line->backsector - sectors;
+	R_AddPortal (front, back, line->v1, line->v2, next);
+	R_AddPortal (back, front, line->v2, line->v1, next);
+    }
+
+    pvsrowbytes = (numsectors+7)>>3;
+    pvs = Z_Malloc (numsectors*pvsrowbytes, PU_LEVEL, NULL);
+    pvsnodes = Z_Malloc (numnodes+1, PU_LEVEL, NULL);
+    pvssubsectors = Z_Malloc (numsubsectors, PU_LEVEL, NULL);
+
+    // Flood from every portal of every sector.
+    overflows = 0;
+    visible = 0;
+    for (i=0 ; i<numsectors ; i++)
+    {
+	pvsrow = pvs + i*pvsrowbytes;
+	memset (pvsrow, 0, pvsrowbytes);
+	pvsrow[i>>3] |= 1<<(i&7);
+	pvsflows = 0;
+
+	for (j=firstportal[i] ; j<firstportal[i+1] ; j++)
+	{
+	    pvsrow[portals[j].to>>3] |= 1<<(portals[j].to&7);
+	    R_FlowPVS (&portals[j].seg, &portals[j].seg, portals[j].to, 1);
+	}
+
+	if (pvsflows > PVS_MAXFLOWS)
+	{
+	    memset (pvsrow, 0xff, pvsrowbytes);
+	    overflows++;
+	}
+
+	for (j=0 ; j<numsectors ; j++)
+	    if (pvsrow[j>>3] & (1<<(j&7)))
+		visible++;
+    }
+
+    Z_Free (portals);
+    Z_Free (next);
+    Z_Free (firstportal);
+
+    if (devparm)
+	printf ("R_BuildPVS: %i portals, %i%% of sectors visible on average,"
+		" %i sectors seeing everything\n",
+		numportals, numsectors ? visible*100/numsectors/numsectors : 0,
+		overflows);
+}
+
+
+//
+// R_MarkPVSNodes
+// Returns true if a sector below is visible.
+//
+static boolean R_MarkPVSNodes (int bspnum)
+{
+    node_t*	bsp;
+    sector_t*	sector;
+    boolean	visible;
+
+    if (bspnum & NF_SUBSECTOR)
+    {
+	if (bspnum == -1)
+	    bspnum = 0;
+	else
+	    bspnum &= ~NF_SUBSECTOR;
+
+	sector = subsectors[bspnum].sector;
+	visible = (pvsrow[(sector-sectors)>>3] & (1<<((sector-sectors)&7))) != 0;
+	pvssubsectors[bspnum] = visible;
+	return visible;
+    }
+
+    bsp = &nodes[bspnum];
+    visible = R_MarkPVSNodes (bsp->children[0]);
+    visible |= R_MarkPVSNodes (bsp->children[1]);
+    pvsnodes[bspnum] = visible;
+
+    return visible;
+}
+
+
+//
+// R_SetupPVS
+// Marks what can be seen from the view sector,
+//  when it changes.
+//
+void R_SetupPVS (void)
+{
+    sector_t*	sector;
+
+    if (!pvs)
+	return;
+
+    sector = R_PointInSubsector (viewx, viewy)->sector;
+    if (sector == pvssector)
+	return;
+
+    pvssector = sector;
+    pvsrow = pvs + (sector-sectors)*pvsrowbytes;
+    R_MarkPVSNodes (numnodes-1);
+}
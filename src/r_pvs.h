@@ -0,0 +1,34 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// Copyright (C) 1993-1996 by id Software, Inc.
+//
+// This source is available for distribution and/or modification
+// only under the terms of the DOOM Source Code License as
+// published by id Software. All rights reserved.
+//
+// The source is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// FITNESS FOR A PARTICULAR PURPOSE. See the DOOM Source Code License
+// for more details.
+//
+// DESCRIPTION:
+//	Potentially visible set of sectors, to prune the BSP traversal.
+//
+//-----------------------------------------------------------------------------
+
+#ifndef __R_PVS__
+#define __R_PVS__
+
+// Nodes and subsectors with a sector possibly visible
+//  from the view sector, NULL without PVS.
+extern byte*	pvsnodes;
+extern byte*	pvssubsectors;
+
+// Called by P_SetupLevel.
+void R_BuildPVS (void);
+
+// Called at frame start.
+void R_SetupPVS (void);
+
+#endif
@@ -44,6 +44,14 @@ int		toptexture;
 int		bottomtexture;
 int		midtexture;
 
+// Column drawers and heights of the wall textures.
+static colfunc_t	topfunc;
+static colfunc_t	bottomfunc;
+static colfunc_t	midfunc;
+static int		topheight;
+static int		bottomheight;
+static int		midheight;
+
 
 angle_t		rw_normalangle;
 // angle to line origin
@@ -58,7 +66,7 @@ angle_t		rw_centerangle;
 fixed_t		rw_offset;
 fixed_t		rw_distance;
 fixed_t		rw_scale;
-fixed_t		rw_scalestep;
+R_THREADLOCAL fixed_t	rw_scalestep;
 fixed_t		rw_midtexturemid;
 fixed_t		rw_toptexturemid;
 fixed_t		rw_bottomtexturemid;
@@ -80,9 +88,9 @@ fixed_t		bottomfrac;
 fixed_t		bottomstep;
 
 
-lighttable_t**	walllights;
+R_THREADLOCAL lighttable_t**	walllights;
 
-short*		maskedtexturecol;
+R_THREADLOCAL short*	maskedtexturecol;
 
 
 
@@ -99,6 +107,14 @@ R_RenderMaskedSegRange
     column_t*	col;
     int		lightnum;
     int		texnum;
+
+    // only the strip of this render thread
+    if (x1 < rcontext->x1)
+	x1 = rcontext->x1;
+    if (x2 > rcontext->x2)
+	x2 = rcontext->x2;
+    if (x1 > x2)
+	return;
     
     // Calculate light table.
     // Use different light tables
@@ -168,15 +184,15 @@ R_RenderMaskedSegRange
 	    dc_iscale = 0xffffffffu / (unsigned)spryscale;
 	    
 	    // draw the texture
-	    col = (column_t *)( 
-		(byte *)R_GetColumn(texnum,maskedtexturecol[dc_x]) -3);
+	    col = R_GetMaskedColumn (texnum, maskedtexturecol[dc_x]);
 			
 	    R_DrawMaskedColumn (col);
 	    maskedtexturecol[dc_x] = MAXSHORT;
 	}
 	spryscale += rw_scalestep;
     }
-	
+
+    R_FlushColumns ();
 }
 
 
@@ -275,7 +291,8 @@ void R_RenderSegLoop (void)
 	    dc_yh = yh;
 	    dc_texturemid = rw_midtexturemid;
 	    dc_source = R_GetColumn(midtexture,texturecolumn);
-	    colfunc ();
+	    dc_texheight = midheight;
+	    R_DrawWallColumn (midfunc);
 	    ceilingclip[rw_x] = viewheight;
 	    floorclip[rw_x] = -1;
 	}
@@ -297,7 +314,8 @@ void R_RenderSegLoop (void)
 		    dc_yh = mid;
 		    dc_texturemid = rw_toptexturemid;
 		    dc_source = R_GetColumn(toptexture,texturecolumn);
-		    colfunc ();
+		    dc_texheight = topheight;
+		    R_DrawWallColumn (topfunc);
 		    ceilingclip[rw_x] = mid;
 		}
 		else
@@ -327,7 +345,8 @@ void R_RenderSegLoop (void)
 		    dc_texturemid = rw_bottomtexturemid;
 		    dc_source = R_GetColumn(bottomtexture,
 					    texturecolumn);
-		    colfunc ();
+		    dc_texheight = bottomheight;
+		    R_DrawWallColumn (bottomfunc);
 		    floorclip[rw_x] = mid;
 		}
 		else
@@ -373,14 +392,16 @@ R_StoreWallRange
     fixed_t		vtop;
     int			lightnum;
 
-    // don't overflow and crash
-    if (ds_p == &drawsegs[MAXDRAWSEGS])
-	return;		
-		
 #ifdef RANGECHECK
     if (start >=viewwidth || start > stop)
 	I_Error ("Bad R_RenderWallRange: %i to %i", start , stop);
 #endif
+
+    // don't overflow and crash
+    R_GrowDrawSegs ();
+
+    // masked texture columns, then top and bottom sprite clips
+    R_CheckOpenings (3*(stop-start+1));
     
     sidedef = curline->sidedef;
     linedef = curline->linedef;
@@ -607,6 +628,23 @@ R_StoreWallRange
     // calculate rw_offset (only needed for textured lines)
     segtextured = midtexture | toptexture | bottomtexture | maskedtexture;
 
+    // pick the column drawers wrapping at the texture heights
+    if (midtexture)
+    {
+	midheight = textureheight[midtexture]>>FRACBITS;
+	midfunc = R_WallColumnFunc (midheight);
+    }
+    if (toptexture)
+    {
+	topheight = textureheight[toptexture]>>FRACBITS;
+	topfunc = R_WallColumnFunc (topheight);
+    }
+    if (bottomtexture)
+    {
+	bottomheight = textureheight[bottomtexture]>>FRACBITS;
+	bottomfunc = R_WallColumnFunc (bottomheight);
+    }
+
     if (segtextured)
     {
 	offsetangle = rw_normalangle-rw_angle1;
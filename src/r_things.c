@@ -67,7 +67,7 @@ typedef struct
 fixed_t		pspritescale;
 fixed_t		pspriteiscale;
 
-lighttable_t**	spritelights;
+R_THREADLOCAL lighttable_t**	spritelights;
 
 // constant arrays
 //  used for psprite clipping and initializing clipping
@@ -189,6 +189,9 @@ void R_InitSpriteDefs (char** namelist)
 	if (!numsprites)
 		return;
 
+	if (R_CachedSpriteDefs (namelist))
+		return;
+
 	sprites = Z_Malloc(numsprites *sizeof(*sprites), PU_STATIC, NULL);
 
 	start = firstspritelump-1;
@@ -279,6 +282,8 @@ void R_InitSpriteDefs (char** namelist)
 			Z_Malloc (maxframe * sizeof(spriteframe_t), PU_STATIC, NULL);
 		memcpy (sprites[i].spriteframes, sprtemp, maxframe*sizeof(spriteframe_t));
 	}
+
+	R_WriteDataCache (namelist);
 }
 
 
@@ -287,9 +292,10 @@ void R_InitSpriteDefs (char** namelist)
 //
 // GAME FUNCTIONS
 //
-vissprite_t	vissprites[MAXVISSPRITES];
+vissprite_t*	vissprites=NULL;
 vissprite_t*	vissprite_p;
 int		newvissprite;
+static int	maxvissprites;
 
 
 
@@ -328,19 +334,37 @@ void R_InitSprites (char** namelist)
 //
 void R_ClearSprites (void)
 {
+    if (!vissprites)
+    {
+	maxvissprites = MAXVISSPRITES;
+	vissprites = Z_Malloc (maxvissprites*sizeof(vissprite_t), PU_STATIC, NULL);
+    }
+
     vissprite_p = vissprites;
 }
 
 
 //
 // R_NewVisSprite
+// Doubles the vissprites when all are used.
 //
-vissprite_t	overflowsprite;
-
 vissprite_t* R_NewVisSprite (void)
 {
-    if (vissprite_p == &vissprites[MAXVISSPRITES])
-	return &overflowsprite;
+    vissprite_t*	newvissprites;
+    int			numvissprites;
+
+    if (vissprite_p == vissprites + maxvissprites)
+    {
+	numvissprites = vissprite_p - vissprites;
+
+	newvissprites = Z_Malloc (2*maxvissprites*sizeof(vissprite_t), PU_STATIC, NULL);
+	memcpy (newvissprites, vissprites, numvissprites*sizeof(vissprite_t));
+	Z_Free (vissprites);
+
+	vissprites = newvissprites;
+	vissprite_p = vissprites + numvissprites;
+	maxvissprites *= 2;
+    }
     
     vissprite_p++;
     return vissprite_p-1;
@@ -354,11 +378,11 @@ vissprite_t* R_NewVisSprite (void)
 // Masked means: partly transparent, i.e. stored
 //  in posts/runs of opaque pixels.
 //
-short*		mfloorclip;
-short*		mceilingclip;
+R_THREADLOCAL short*	mfloorclip;
+R_THREADLOCAL short*	mceilingclip;
 
-fixed_t		spryscale;
-fixed_t		sprtopscreen;
+R_THREADLOCAL fixed_t	spryscale;
+R_THREADLOCAL fixed_t	sprtopscreen;
 
 void R_DrawMaskedColumn (column_t* column)
 {
@@ -404,6 +428,8 @@ void R_DrawMaskedColumn (column_t* column)
 //
 // R_DrawVisSprite
 //  mfloorclip and mceilingclip should also be set.
+//  Columns x1 to x2 are drawn, within the strip
+//  of the current render thread.
 //
 void
 R_DrawVisSprite
@@ -416,8 +442,14 @@ R_DrawVisSprite
 	fixed_t		frac;
 	patch_t*		patch;
 
+	if (x1 < rcontext->x1)
+		x1 = rcontext->x1;
+	if (x2 > rcontext->x2)
+		x2 = rcontext->x2;
+	if (x1 > x2)
+		return;
 
-	patch = W_CacheLumpNum (vis->patch+firstspritelump, PU_CACHE);
+	patch = R_CacheLumpNum (vis->patch+firstspritelump);
 
 	dc_colormap = vis->colormap;
 
@@ -432,11 +464,11 @@ R_DrawVisSprite
 
 	dc_iscale = abs(vis->xiscale)>>detailshift;
 	dc_texturemid = vis->texturemid;
-	frac = vis->startfrac;
+	frac = vis->startfrac + (x1-vis->x1)*vis->xiscale;
 	spryscale = vis->scale;
 	sprtopscreen = centeryfrac - FixedMul(dc_texturemid,spryscale);
 
-	for (dc_x=vis->x1 ; dc_x<=vis->x2 ; dc_x++, frac += vis->xiscale) {
+	for (dc_x=x1 ; dc_x<=x2 ; dc_x++, frac += vis->xiscale) {
 		texturecolumn = frac>>FRACBITS;
 #ifdef RANGECHECK
 		if (texturecolumn < 0 || texturecolumn >= SHORT(patch->width))
@@ -447,6 +479,7 @@ R_DrawVisSprite
 		R_DrawMaskedColumn (column);
 	}
 
+	R_FlushColumns ();
 	colfunc = basecolfunc;
 }
 
@@ -783,54 +816,88 @@ void R_DrawPlayerSprites (void)
 
 //
 // R_SortVisSprites
+// Merge sort of the vissprites by scale, farthest first.
+// Sprites of the same scale stay in the order they were
+//  projected in, as with the original selection sort,
+//  so the picture does not change.
 //
 vissprite_t	vsprsortedhead;
 
 
 void R_SortVisSprites (void)
 {
-	int			i;
-	int			count;
-	vissprite_t*	ds;
-	vissprite_t*	best=NULL;
-	vissprite_t		unsorted;
-	fixed_t		bestscale;
-
-	count = vissprite_p - vissprites;
+	vissprite_t*	list;
+	vissprite_t*	tail;
+	vissprite_t*	p;
+	vissprite_t*	q;
+	vissprite_t*	e;
+	int		insize;
+	int		psize;
+	int		qsize;
+	int		merges;
 
-	unsorted.next = unsorted.prev = &unsorted;
+	vsprsortedhead.next = vsprsortedhead.prev = &vsprsortedhead;
 
-	if (!count)
+	if (vissprite_p == vissprites)
 		return;
-		
-	for (ds=vissprites ; ds<vissprite_p ; ds++) {
-		ds->next = ds+1;
-		ds->prev = ds-1;
-	}
 
-	vissprites[0].prev = &unsorted;
-	unsorted.next = &vissprites[0];
-	(vissprite_p-1)->next = &unsorted;
-	unsorted.prev = vissprite_p-1;
+	// single linked in projection order for the sort
+	for (e=vissprites ; e<vissprite_p-1 ; e++)
+		e->next = e+1;
+	e->next = NULL;
+	list = vissprites;
+
+	// merge runs of insize, until only one is left
+	for (insize=1 ; ; insize*=2) {
+		p = list;
+		list = tail = NULL;
+		merges = 0;
+
+		while (p) {
+			merges++;
+
+			q = p;
+			for (psize=0 ; q && psize<insize ; psize++)
+				q = q->next;
+			qsize = insize;
+
+			while (psize > 0 || (qsize > 0 && q)) {
+				// the first run wins on equal scales
+				if (psize && (!qsize || !q || p->scale <= q->scale)) {
+					e = p;
+					p = p->next;
+					psize--;
+				} else {
+					e = q;
+					q = q->next;
+					qsize--;
+				}
 
-	// pull the vissprites out by scale
-	//best = 0;		// shut up the compiler warning
-	vsprsortedhead.next = vsprsortedhead.prev = &vsprsortedhead;
-	for (i=0 ; i<count ; i++) {
-		bestscale = MAXINT;
-		for (ds=unsorted.next ; ds!= &unsorted ; ds=ds->next) {
-			if (ds->scale < bestscale) {
-				bestscale = ds->scale;
-				best = ds;
+				if (tail)
+					tail->next = e;
+				else
+					list = e;
+				tail = e;
 			}
+
+			p = q;
 		}
-		best->next->prev = best->prev;
-		best->prev->next = best->next;
-		best->next = &vsprsortedhead;
-		best->prev = vsprsortedhead.prev;
-		vsprsortedhead.prev->next = best;
-		vsprsortedhead.prev = best;
+		tail->next = NULL;
+
+		if (merges <= 1)
+			break;
+	}
+
+	// double link them behind vsprsortedhead
+	tail = &vsprsortedhead;
+	for (p=list ; p ; p=q) {
+		q = p->next;
+		p->prev = tail;
+		tail->next = p;
+		tail = p;
 	}
+	tail->next = &vsprsortedhead;
+	vsprsortedhead.prev = tail;
 }
 
 
@@ -844,16 +911,24 @@ void R_DrawSprite (vissprite_t* spr)
     short		*clipbot;
     short		*cliptop;
     int			x;
+    int			x1;
+    int			x2;
     int			r1;
     int			r2;
     fixed_t		scale;
     fixed_t		lowscale;
     int			silhouette;
 
-	clipbot = Z_Malloc(sysvideo.width*sizeof(short), PU_STATIC, NULL);
-	cliptop = Z_Malloc(sysvideo.width*sizeof(short), PU_STATIC, NULL);
+    // only the strip of this render thread
+    x1 = spr->x1 < rcontext->x1 ? rcontext->x1 : spr->x1;
+    x2 = spr->x2 > rcontext->x2 ? rcontext->x2 : spr->x2;
+    if (x1 > x2)
+	return;
+
+    clipbot = rcontext->clipbot;
+    cliptop = rcontext->cliptop;
 		
-    for (x = spr->x1 ; x<=spr->x2 ; x++)
+    for (x = x1 ; x<=x2 ; x++)
 	clipbot[x] = cliptop[x] = -2;
     
     // Scan drawsegs from end to start for obscuring segs.
@@ -862,8 +937,8 @@ void R_DrawSprite (vissprite_t* spr)
     for (ds=ds_p-1 ; ds >= drawsegs ; ds--)
     {
 	// determine if the drawseg obscures the sprite
-	if (ds->x1 > spr->x2
-	    || ds->x2 < spr->x1
+	if (ds->x1 > x2
+	    || ds->x2 < x1
 	    || (!ds->silhouette
 		&& !ds->maskedtexturecol) )
 	{
@@ -871,8 +946,8 @@ void R_DrawSprite (vissprite_t* spr)
 	    continue;
 	}
 			
-	r1 = ds->x1 < spr->x1 ? spr->x1 : ds->x1;
-	r2 = ds->x2 > spr->x2 ? spr->x2 : ds->x2;
+	r1 = ds->x1 < x1 ? x1 : ds->x1;
+	r2 = ds->x2 > x2 ? x2 : ds->x2;
 
 	if (ds->scale1 > ds->scale2)
 	{
@@ -937,7 +1012,7 @@ void R_DrawSprite (vissprite_t* spr)
     // all clipping has been performed, so draw the sprite
 
     // check for unclipped columns
-    for (x = spr->x1 ; x<=spr->x2 ; x++)
+    for (x = x1 ; x<=x2 ; x++)
     {
 	if (clipbot[x] == -2)		
 	    clipbot[x] = viewheight;
@@ -948,25 +1023,75 @@ void R_DrawSprite (vissprite_t* spr)
 		
     mfloorclip = clipbot;
     mceilingclip = cliptop;
-    R_DrawVisSprite (spr, spr->x1, spr->x2);
-
-	Z_Free(cliptop);
-	Z_Free(clipbot);
+    R_DrawVisSprite (spr, x1, x2);
 }
 
 
 
 
 //
-// R_DrawMasked
+// R_PrepMasked
+// Sorts the vissprites and gets all masked graphics ready.
+// Returns false if the masked things can not be drawn by strips,
+//  as the running fuzz offset of shadow draws spans the whole view.
 //
-void R_DrawMasked (void)
+boolean R_PrepMasked (void)
 {
 	vissprite_t*	spr;
 	drawseg_t*		ds;
+	pspdef_t*		psp;
+	spriteframe_t*	sprframe;
+	boolean			shadow;
+	int				i;
 
 	R_SortVisSprites ();
 
+	renderstats.vissprites = vissprite_p - vissprites;
+
+	shadow = false;
+
+	for (spr = vissprites ; spr < vissprite_p ; spr++) {
+		if (!spr->colormap)
+			shadow = true;
+		if (r_pincache)
+			R_CacheLumpNum (spr->patch+firstspritelump);
+	}
+
+	if (!viewangleoffset) {
+		if (viewplayer->powers[pw_invisibility] > 4*32
+			|| viewplayer->powers[pw_invisibility] & 8)
+		{
+			shadow = true;
+		}
+
+		for (i=0, psp=viewplayer->psprites; i<NUMPSPRITES; i++,psp++) {
+			if (!psp->state || !r_pincache)
+				continue;
+			sprframe = &sprites[psp->state->sprite].spriteframes[
+				psp->state->frame & FF_FRAMEMASK ];
+			R_CacheLumpNum (sprframe->lump[0]+firstspritelump);
+		}
+	}
+
+	if (r_pincache) {
+		for (ds=ds_p-1 ; ds >= drawsegs ; ds--)
+			if (ds->maskedtexturecol)
+				R_PinTexture (texturetranslation[ds->curline->sidedef->midtexture]);
+	}
+
+	return !shadow;
+}
+
+
+//
+// R_DrawMasked
+// R_PrepMasked must have been called first.
+//
+void R_DrawMasked (void)
+{
+	vissprite_t*	spr;
+	drawseg_t*		ds;
+
 	if (vissprite_p > vissprites) {
 		// draw all vissprites back to front
 		for (spr = vsprsortedhead.next ;
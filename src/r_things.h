@@ -20,9 +20,10 @@
 #ifndef __R_THINGS__
 #define __R_THINGS__
 
+// Allocated at first, more are added when needed.
 #define MAXVISSPRITES  	128
 
-extern vissprite_t	vissprites[MAXVISSPRITES];
+extern vissprite_t*	vissprites;
 extern vissprite_t*	vissprite_p;
 extern vissprite_t	vsprsortedhead;
 
@@ -32,10 +33,10 @@ extern short		*negonearray;
 extern short		*screenheightarray;
 
 // vars for R_DrawMaskedColumn
-extern short*		mfloorclip;
-extern short*		mceilingclip;
-extern fixed_t		spryscale;
-extern fixed_t		sprtopscreen;
+extern R_THREADLOCAL short*	mfloorclip;
+extern R_THREADLOCAL short*	mceilingclip;
+extern R_THREADLOCAL fixed_t	spryscale;
+extern R_THREADLOCAL fixed_t	sprtopscreen;
 
 extern fixed_t		pspritescale;
 extern fixed_t		pspriteiscale;
@@ -51,6 +52,7 @@ void R_AddPSprites (void);
 void R_DrawSprites (void);
 void R_InitSprites (char** namelist);
 void R_ClearSprites (void);
+boolean R_PrepMasked (void);
 void R_DrawMasked (void);
 
 void
@@ -0,0 +1,344 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// Copyright (C) 1993-1996 by id Software, Inc.
+//
+// This source is available for distribution and/or modification
+// only under the terms of the DOOM Source Code License as
+// published by id Software. All rights reserved.
+//
+// The source is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// FITNESS FOR A PARTICULAR PURPOSE. See the DOOM Source Code License
+// for more details.
+//
+// DESCRIPTION:
+//	Drawing the view in vertical strips, one per thread.
+//	The BSP traversal and all clipping stay on the main thread,
+//	 so drawsegs, visplanes and vissprites are the same as when
+//	 drawing alone. Wall columns are queued during the traversal,
+//	 then each thread draws the walls, planes and masked things
+//	 falling in its own strip, giving the very same picture.
+//	Only the main thread ever calls the zone, see r_pincache.
+//
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <string.h>
+
+#include <SDL.h>
+
+#include "z_zone.h"
+
+#include "doomdef.h"
+
+#include "r_local.h"
+#include "r_thread.h"
+
+#include "i_video.h"
+
+
+R_THREADLOCAL rendercontext_t*	rcontext;
+int			numrenderthreads = 1;
+
+static rendercontext_t	contexts[MAXRENDERTHREADS];
+
+#ifdef ENABLE_RENDER_THREADS
+static SDL_Thread*	threads[MAXRENDERTHREADS];
+static SDL_sem*		startsem[MAXRENDERTHREADS];
+static SDL_sem*		donesem;
+static void		(*stripfunc) (void);
+#endif
+
+
+//
+// Wall columns queued by R_RenderSegLoop.
+//
+typedef struct
+{
+    int			x;
+    int			yl;
+    int			yh;
+    fixed_t		iscale;
+    fixed_t		texturemid;
+    byte*		source;
+    lighttable_t*	colormap;
+    int			texheight;
+    colfunc_t		func;
+
+} wallcolumn_t;
+
+static wallcolumn_t*	wallcolumns=NULL;
+static int		numwallcolumns;
+static int		maxwallcolumns;
+static boolean		queuewalls;
+
+
+#ifdef ENABLE_RENDER_THREADS
+//
+// R_StripThread
+// Waits for a strip to draw, forever.
+//
+static int R_StripThread (void* data)
+{
+    int		i;
+
+    rcontext = (rendercontext_t *) data;
+    i = rcontext - contexts;
+
+    for (;;)
+    {
+	SDL_SemWait (startsem[i]);
+	colfunc = basecolfunc;
+	stripfunc ();
+	SDL_SemPost (donesem);
+    }
+
+    return 0;
+}
+#endif
+
+
+//
+// R_InitRenderThreads
+// Only at game startup, before R_InitPlanes.
+//
+void R_InitRenderThreads (void)
+{
+    int		wanted;
+
+    wanted = sysvideo.render_threads;
+    if (wanted < 1)
+	wanted = 1;
+    else if (wanted > MAXRENDERTHREADS)
+	wanted = MAXRENDERTHREADS;
+
+    numrenderthreads = 1;
+    rcontext = &contexts[0];
+
+#ifdef ENABLE_RENDER_THREADS
+    donesem = SDL_CreateSemaphore (0);
+    if (!donesem)
+	wanted = 1;
+
+    while (numrenderthreads < wanted)
+    {
+	startsem[numrenderthreads] = SDL_CreateSemaphore (0);
+	if (!startsem[numrenderthreads])
+	    break;
+
+	threads[numrenderthreads] = SDL_CreateThread (R_StripThread,
+					&contexts[numrenderthreads]);
+	if (!threads[numrenderthreads])
+	{
+	    SDL_DestroySemaphore (startsem[numrenderthreads]);
+	    break;
+	}
+	numrenderthreads++;
+    }
+
+    if (numrenderthreads < wanted)
+	printf ("R_InitRenderThreads: only %d render threads\n",
+		numrenderthreads);
+#else
+    if (wanted > 1)
+	printf ("R_InitRenderThreads: built without render threads\n");
+#endif
+}
+
+
+//
+// R_InitRenderContexts
+// Called by R_InitPlanes, for each screen size.
+//
+#define	ALLOCATE_ARRAY(pointer, size, type) \
+	if (pointer) {	\
+		Z_Free(pointer); \
+	}	\
+	\
+	pointer = Z_Malloc(sizeof(type)*size, PU_STATIC, NULL);
+
+void R_InitRenderContexts (void)
+{
+    rendercontext_t*	context;
+    int			i;
+
+    for (i=0, context=contexts ; i<numrenderthreads ; i++, context++)
+    {
+	ALLOCATE_ARRAY(context->spanstart, sysvideo.height, int);
+	ALLOCATE_ARRAY(context->cachedheight, sysvideo.height, fixed_t);
+	ALLOCATE_ARRAY(context->cacheddistance, sysvideo.height, fixed_t);
+	ALLOCATE_ARRAY(context->cachedxstep, sysvideo.height, fixed_t);
+	ALLOCATE_ARRAY(context->cachedystep, sysvideo.height, fixed_t);
+	ALLOCATE_ARRAY(context->clipbot, sysvideo.width, short);
+	ALLOCATE_ARRAY(context->cliptop, sysvideo.width, short);
+	ALLOCATE_ARRAY(context->quadbuffer, sysvideo.height*4, byte);
+    }
+}
+
+
+//
+// R_DrawWallColumn
+// Draws a wall column with func, or queues it while the BSP
+//  is traversed for several threads.
+//
+void R_DrawWallColumn (colfunc_t func)
+{
+    wallcolumn_t*	column;
+
+    if (!queuewalls)
+    {
+	func ();
+	return;
+    }
+
+    // Zero length, nothing to draw.
+    if (dc_yh < dc_yl)
+	return;
+
+    if (numwallcolumns == maxwallcolumns)
+    {
+	maxwallcolumns = maxwallcolumns ? maxwallcolumns*2 : sysvideo.width*4;
+	column = Z_Malloc (maxwallcolumns*sizeof(wallcolumn_t), PU_STATIC, NULL);
+	if (wallcolumns)
+	{
+	    memcpy (column, wallcolumns, numwallcolumns*sizeof(wallcolumn_t));
+	    Z_Free (wallcolumns);
+	}
+	wallcolumns = column;
+    }
+
+    column = &wallcolumns[numwallcolumns++];
+    column->x = dc_x;
+    column->yl = dc_yl;
+    column->yh = dc_yh;
+    column->iscale = dc_iscale;
+    column->texturemid = dc_texturemid;
+    column->source = dc_source;
+    column->colormap = dc_colormap;
+    column->texheight = dc_texheight;
+    column->func = func;
+}
+
+
+//
+// R_DrawQueuedColumns
+// Draws the queued wall columns of the current strip.
+//
+void R_DrawQueuedColumns (void)
+{
+    wallcolumn_t*	column;
+    wallcolumn_t*	end;
+
+    end = wallcolumns + numwallcolumns;
+
+    for (column = wallcolumns ; column < end ; column++)
+    {
+	if (column->x < rcontext->x1 || column->x > rcontext->x2)
+	    continue;
+
+	dc_x = column->x;
+	dc_yl = column->yl;
+	dc_yh = column->yh;
+	dc_iscale = column->iscale;
+	dc_texturemid = column->texturemid;
+	dc_source = column->source;
+	dc_colormap = column->colormap;
+	dc_texheight = column->texheight;
+
+	column->func ();
+    }
+
+    R_FlushColumns ();
+}
+
+
+//
+// R_StartStrips
+// At begining of frame, splits the view between the threads.
+//
+void R_StartStrips (void)
+{
+    int		i;
+
+    for (i=0 ; i<numrenderthreads ; i++)
+    {
+	contexts[i].x1 = viewwidth*i/numrenderthreads;
+	contexts[i].x2 = viewwidth*(i+1)/numrenderthreads - 1;
+    }
+
+    numwallcolumns = 0;
+
+    if (numrenderthreads > 1)
+    {
+	queuewalls = true;
+	r_pincache = true;
+    }
+}
+
+
+//
+// R_RunStrips
+// Calls func for every strip, the main thread drawing the first one.
+//
+void R_RunStrips (void (*func) (void))
+{
+#ifdef ENABLE_RENDER_THREADS
+    int		i;
+#endif
+
+    colfunc = basecolfunc;
+    queuewalls = false;
+
+#ifdef ENABLE_RENDER_THREADS
+    if (numrenderthreads > 1)
+    {
+	stripfunc = func;
+
+	for (i=1 ; i<numrenderthreads ; i++)
+	    SDL_SemPost (startsem[i]);
+
+	func ();
+
+	for (i=1 ; i<numrenderthreads ; i++)
+	    SDL_SemWait (donesem);
+	return;
+    }
+#endif
+
+    func ();
+}
+
+
+//
+// R_RunView
+// Calls func on the main thread, for the whole view.
+//
+void R_RunView (void (*func) (void))
+{
+    int		x1;
+    int		x2;
+
+    x1 = rcontext->x1;
+    x2 = rcontext->x2;
+
+    rcontext->x1 = 0;
+    rcontext->x2 = viewwidth-1;
+
+    colfunc = basecolfunc;
+    func ();
+
+    rcontext->x1 = x1;
+    rcontext->x2 = x2;
+}
+
+
+//
+// R_FinishStrips
+// At the end of the frame.
+//
+void R_FinishStrips (void)
+{
+    if (r_pincache)
+	R_UnpinCache ();
+}
@@ -0,0 +1,67 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// Copyright (C) 1993-1996 by id Software, Inc.
+//
+// This source is available for distribution and/or modification
+// only under the terms of the DOOM Source Code License as
+// published by id Software. All rights reserved.
+//
+// The source is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// FITNESS FOR A PARTICULAR PURPOSE. See the DOOM Source Code License
+// for more details.
+//
+// DESCRIPTION:
+//	Drawing the view in vertical strips, one per thread.
+//
+//-----------------------------------------------------------------------------
+
+#ifndef __R_THREAD__
+#define __R_THREAD__
+
+#define MAXRENDERTHREADS	8
+
+//
+// Everything a thread needs to draw its own strip,
+//  besides the R_THREADLOCAL globals.
+//
+typedef struct
+{
+    // Columns of the view drawn by this thread.
+    int		x1;
+    int		x2;
+
+    // R_MakeSpans / R_MapPlane state.
+    int*	spanstart;
+    fixed_t*	cachedheight;
+    fixed_t*	cacheddistance;
+    fixed_t*	cachedxstep;
+    fixed_t*	cachedystep;
+
+    // R_DrawSprite clipping.
+    short*	clipbot;
+    short*	cliptop;
+
+    // R_DrawColumnQuad, 4 bytes per row.
+    byte*	quadbuffer;
+
+} rendercontext_t;
+
+extern R_THREADLOCAL rendercontext_t*	rcontext;
+extern int		numrenderthreads;
+
+
+void R_InitRenderThreads (void);
+void R_InitRenderContexts (void);
+
+// Wall columns are queued while the BSP is traversed.
+void R_DrawWallColumn (colfunc_t func);
+void R_DrawQueuedColumns (void);
+
+void R_StartStrips (void);
+void R_RunStrips (void (*func) (void));
+void R_RunView (void (*func) (void));
+void R_FinishStrips (void);
+
+#endif
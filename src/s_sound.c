@@ -18,6 +18,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <SDL.h>
 
@@ -151,10 +152,6 @@ void S_Init
   int		i;
 
 //  fprintf( stderr, "S_Init: default sfx volume %d\n", sfxVolume);
-  I_SetChannels();
-  S_SetSfxVolume(sfxVolume);
-  S_SetMusicVolume(musicVolume);
-
   // Allocating the internal channels for mixing
   // (the maximum numer of sounds rendered
   // simultaneously) within zone memory.
@@ -162,6 +159,10 @@ void S_Init
 		numChannels = NUM_CHANNELS;
 	}
 
+  I_SetChannels(numChannels);
+  S_SetSfxVolume(sfxVolume);
+  S_SetMusicVolume(musicVolume);
+
     channels = (channel_t *) Z_Malloc(numChannels*sizeof(channel_t), PU_STATIC, 0);
   
     // Free all channels for use
@@ -242,6 +243,203 @@ void S_Start(void)
 
 
 
+//
+// S_CacheSfx
+// Loads the sound data if needed.
+//
+static void S_CacheSfx(sfxinfo_t* sfx)
+{
+	// get lumpnum if necessary
+	if (sfx->lumpnum < 0)
+		sfx->lumpnum = I_GetSfxLumpNum(sfx);
+
+	// cache data if necessary
+	if (!sfx->data) {
+		int length;
+		sfx->data = I_LoadSfx(sfx, &length);
+		sfx->length = length;
+		sfx->usefulness=0;
+	}
+}
+
+
+//
+// Sounds of things not found in their mobjinfo,
+//  played by their action functions or their missiles.
+//
+typedef struct
+{
+	mobjtype_t	type;
+	mobjtype_t	missile;	// NUMMOBJTYPES if none
+	int		sounds[6];	// ended by sfx_None
+
+} thingsounds_t;
+
+static thingsounds_t	thingsounds[] =
+{
+	{MT_VILE, MT_FIRE, {sfx_vilatk, sfx_flamst, sfx_flame, sfx_barexp}},
+	{MT_UNDEAD, MT_TRACER, {sfx_skeswg, sfx_skepch}},
+	{MT_FATSO, MT_FATSHOT, {sfx_manatk}},
+	{MT_TROOP, MT_TROOPSHOT, {sfx_claw}},
+	{MT_HEAD, MT_HEADSHOT},
+	{MT_BRUISER, MT_BRUISERSHOT, {sfx_claw}},
+	{MT_KNIGHT, MT_BRUISERSHOT, {sfx_claw}},
+	{MT_SPIDER, NUMMOBJTYPES, {sfx_metal}},
+	{MT_BABY, MT_ARACHPLAZ, {sfx_bspwlk}},
+	{MT_CYBORG, MT_ROCKET, {sfx_hoof, sfx_metal}},
+	{MT_PAIN, MT_SKULL},
+	{MT_BOSSBRAIN, MT_SPAWNSHOT,
+	 {sfx_bossit, sfx_bospn, sfx_bospit, sfx_bosdth, sfx_boscub}},
+	{MT_BARREL, NUMMOBJTYPES, {sfx_barexp}}
+};
+
+//
+// Sounds of the weapons, owned or lying on the level.
+//
+typedef struct
+{
+	weapontype_t	weapon;
+	mobjtype_t	pickup;		// NUMMOBJTYPES if none
+	mobjtype_t	missile;	// NUMMOBJTYPES if none
+	int		sounds[5];	// ended by sfx_None
+
+} weaponsounds_t;
+
+static weaponsounds_t	weaponsounds[] =
+{
+	{wp_fist, NUMMOBJTYPES, NUMMOBJTYPES, {sfx_punch}},
+	{wp_pistol, NUMMOBJTYPES, NUMMOBJTYPES, {sfx_pistol}},
+	{wp_shotgun, MT_SHOTGUN, NUMMOBJTYPES, {sfx_shotgn}},
+	{wp_chaingun, MT_CHAINGUN, NUMMOBJTYPES, {sfx_pistol}},
+	{wp_missile, MT_MISC27, MT_ROCKET, {sfx_rlaunc}},
+	{wp_plasma, MT_MISC28, MT_PLASMA, {sfx_plasma}},
+	{wp_bfg, MT_MISC25, MT_BFG, {sfx_bfg}},
+	{wp_chainsaw, MT_MISC26, NUMMOBJTYPES,
+	 {sfx_sawup, sfx_sawidl, sfx_sawful, sfx_sawhit}},
+	{wp_supershotgun, MT_SUPERSHOTGUN, NUMMOBJTYPES,
+	 {sfx_dshtgn, sfx_dbopn, sfx_dbload, sfx_dbcls}}
+};
+
+//
+// Heard on every level, from the player and the map.
+//
+static int	levelsounds[] =
+{
+	sfx_oof, sfx_noway, sfx_slop, sfx_telept, sfx_itemup, sfx_wpnup,
+	sfx_getpow, sfx_doropn, sfx_dorcls, sfx_bdopn, sfx_bdcls,
+	sfx_pstart, sfx_pstop, sfx_stnmov, sfx_swtchn, sfx_swtchx,
+	sfx_None
+};
+
+
+//
+// S_MarkThingSounds
+//
+static void S_MarkThingSounds(byte* present, mobjtype_t type)
+{
+	mobjinfo_t*	info;
+
+	if (type == NUMMOBJTYPES)
+		return;
+
+	info = &mobjinfo[type];
+	present[info->seesound] = 1;
+	present[info->attacksound] = 1;
+	present[info->painsound] = 1;
+	present[info->deathsound] = 1;
+	present[info->activesound] = 1;
+}
+
+
+//
+// S_PrecacheSounds
+// Loads the sounds the level may play, so they
+//  are resampled before it starts.
+//
+void S_PrecacheSounds(void)
+{
+	byte*		present;
+	boolean*	typepresent;
+	boolean		owned;
+	thinker_t*	th;
+	int		count;
+	int		bytes;
+	int		i;
+	int		j;
+
+	if (!sysaudio.sound_enabled)
+		return;
+
+	present = Z_Malloc(NUMSFX, PU_STATIC, NULL);
+	typepresent = Z_Malloc(NUMMOBJTYPES*sizeof(boolean), PU_STATIC, NULL);
+	memset(present, 0, NUMSFX);
+	memset(typepresent, 0, NUMMOBJTYPES*sizeof(boolean));
+
+	for (i=0 ; levelsounds[i] != sfx_None ; i++)
+		present[levelsounds[i]] = 1;
+
+	typepresent[MT_PLAYER] = true;
+	typepresent[MT_TFOG] = true;
+	typepresent[MT_IFOG] = true;
+	typepresent[MT_PUFF] = true;
+
+	for (th = thinkercap.next ; th != &thinkercap ; th = th->next) {
+		if (th->function.acp1 == (actionf_p1)P_MobjThinker)
+			typepresent[((mobj_t *)th)->type] = true;
+	}
+
+	for (i=0 ; i<sizeof(thingsounds)/sizeof(thingsounds[0]) ; i++) {
+		if (!typepresent[thingsounds[i].type])
+			continue;
+
+		S_MarkThingSounds(present, thingsounds[i].missile);
+		for (j=0 ; thingsounds[i].sounds[j] != sfx_None ; j++)
+			present[thingsounds[i].sounds[j]] = 1;
+	}
+
+	for (i=0 ; i<sizeof(weaponsounds)/sizeof(weaponsounds[0]) ; i++) {
+		owned = weaponsounds[i].pickup != NUMMOBJTYPES
+			&& typepresent[weaponsounds[i].pickup];
+
+		for (j=0 ; j<MAXPLAYERS ; j++) {
+			if (playeringame[j]
+				&& players[j].weaponowned[weaponsounds[i].weapon])
+				owned = true;
+		}
+
+		if (!owned)
+			continue;
+
+		S_MarkThingSounds(present, weaponsounds[i].missile);
+		for (j=0 ; weaponsounds[i].sounds[j] != sfx_None ; j++)
+			present[weaponsounds[i].sounds[j]] = 1;
+	}
+
+	for (i=0 ; i<NUMMOBJTYPES ; i++) {
+		if (typepresent[i])
+			S_MarkThingSounds(present, i);
+	}
+
+	count = 0;
+	bytes = 0;
+	for (i=1 ; i<NUMSFX ; i++) {
+		if (!present[i])
+			continue;
+
+		S_CacheSfx(&S_sfx[i]);
+		count++;
+		bytes += S_sfx[i].length;
+	}
+
+	Z_Free(typepresent);
+	Z_Free(present);
+
+	if (devparm)
+		printf("S_PrecacheSounds: %i sounds, %i KB\n", count, bytes>>10);
+}
+
+
+
 void
 S_StartSoundAtVolume
 ( void*		origin_p,
@@ -339,18 +537,7 @@ S_StartSoundAtVolume
 	// For some odd reason, the caching is done nearly
 	//  each time the sound is needed?
 	//
-
-	// get lumpnum if necessary
-	if (sfx->lumpnum < 0)
-		sfx->lumpnum = I_GetSfxLumpNum(sfx);
-
-	// cache data if necessary
-	if (!sfx->data) {
-		int length;
-		sfx->data = I_LoadSfx(sfx->name, &length);
-		sfx->length = length;
-		sfx->usefulness=0;
-	}
+	S_CacheSfx(sfx);
 
 	sfx->usefulness++;
 
@@ -597,6 +784,7 @@ S_ChangeMusic
 {
 	musicinfo_t*	music=NULL;
 	char		namebuf[9];
+	int		length;
 
 	if ( (musicnum <= mus_None) || (musicnum >= NUMMUSIC) ) {
 		I_Error("Bad music number %d", musicnum);
@@ -639,8 +827,8 @@ S_ChangeMusic
 	}
 
 	// load & register it
-	music->data = (void *) W_CacheLumpNum(music->lumpnum, PU_MUSIC);
-	music->handle = I_RegisterSong(music->data, W_LumpLength(music->lumpnum));
+	music->data = I_CacheSong(music->lumpnum, PU_MUSIC, &length);
+	music->handle = I_RegisterSong(music->data, length);
 
 	// play it
 	I_PlaySong(music->handle, looping);
@@ -657,7 +845,7 @@ void S_StopMusic(void)
 
 		I_StopSong(mus_playing->handle);
 		I_UnRegisterSong(mus_playing->handle);
-		Z_ChangeTag(mus_playing->data, PU_CACHE);
+		I_ReleaseSong(mus_playing->lumpnum);
 
 		mus_playing->data = 0;
 		mus_playing = 0;
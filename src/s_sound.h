@@ -40,6 +40,12 @@ S_Init
 //
 void S_Start(void);
 
+//
+// Loads the sounds of the things and weapons
+//  of the level, after they are spawned.
+//
+void S_PrecacheSounds(void);
+
 
 //
 // Start sound for thing at <origin>
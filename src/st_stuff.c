@@ -1163,33 +1163,33 @@ void ST_unloadGraphics(void)
 
 	// unload the numbers, tall and short
 	for (i=0;i<10;i++) {
-		Z_ChangeTag(tallnum[i], PU_CACHE);
-		Z_ChangeTag(shortnum[i], PU_CACHE);
+		W_ReleaseLump(tallnum[i]);
+		W_ReleaseLump(shortnum[i]);
 	}
 	// unload tall percent
-	Z_ChangeTag(tallpercent, PU_CACHE); 
+	W_ReleaseLump(tallpercent); 
 
 	// unload arms background
-	Z_ChangeTag(armsbg, PU_CACHE); 
+	W_ReleaseLump(armsbg); 
 
 	// unload gray #'s
 	for (i=0;i<6;i++)
-		Z_ChangeTag(arms[i][0], PU_CACHE);
+		W_ReleaseLump(arms[i][0]);
 
 	// unload the key cards
 	for (i=0;i<NUMCARDS;i++)
-		Z_ChangeTag(keys[i], PU_CACHE);
+		W_ReleaseLump(keys[i]);
 
 	if (sbar) {
-		Z_ChangeTag(sbar, PU_CACHE);
+		W_ReleaseLump(sbar);
 	} else {
-		Z_ChangeTag(sbar_right, PU_CACHE);
-		Z_ChangeTag(sbar_left, PU_CACHE);
+		W_ReleaseLump(sbar_right);
+		W_ReleaseLump(sbar_left);
 	}
-	Z_ChangeTag(faceback, PU_CACHE);
+	W_ReleaseLump(faceback);
 
 	for (i=0;i<ST_NUMFACES;i++)
-		Z_ChangeTag(faces[i], PU_CACHE);
+		W_ReleaseLump(faces[i]);
 
 	// Note: nobody ain't seen no unloading
 	//   of stminus yet. Dude.
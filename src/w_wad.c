@@ -28,6 +28,9 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/stat.h>
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#endif
 
 #include "doomtype.h"
 #include "m_swap.h"
@@ -42,6 +45,8 @@
 
 #define LUMPINFO_START_SIZE	16
 
+#define MAXMAPPEDFILES		20
+
 //
 // GLOBALS
 //
@@ -53,6 +58,24 @@ static int	lumpinfo_size;	/* for realloc */
 
 void**			lumpcache;
 
+// Hash chains of lumps by name, latest lump first.
+static int*		lumphash=NULL;
+static int		lumphashsize;
+
+// Name lookups done, lumps compared, and lumps
+//  a backwards linear scan would have compared.
+static int		lookups;
+static int		probes;
+static int		linearprobes;
+
+// Files mapped with -mmap, to tell their lumps from zone blocks.
+static byte*		mapbases[MAXMAPPEDFILES];
+static int		maplengths[MAXMAPPEDFILES];
+static int		nummapped;
+
+// Size and date of every file added, for W_Checksum.
+static unsigned		filestamp = 2166136261UL;
+
 #ifndef HAVE_STRUPR
 void strupr (char* s)
 {
@@ -109,6 +132,133 @@ ExtractFileBase
 // LUMP BASED ROUTINES.
 //
 
+//
+// W_HashName
+// Takes the name as two integers, like W_CheckNumForName.
+//
+static unsigned W_HashName (int v1, int v2)
+{
+	unsigned	hash;
+
+	hash = (unsigned)v1 * 0x9e3779b1UL;
+	hash ^= (unsigned)v2 + (hash >> 15);
+	hash *= 0x85ebca6bUL;
+
+	return (hash ^ (hash >> 16)) & (lumphashsize-1);
+}
+
+
+//
+// W_HashBytes
+// FNV-1a, continuing from sum.
+//
+static unsigned W_HashBytes (unsigned sum, void* data, int length)
+{
+	byte*	p;
+
+	for (p=(byte *)data ; length>0 ; length--, p++) {
+		sum ^= *p;
+		sum *= 16777619UL;
+	}
+
+	return sum;
+}
+
+
+static boolean W_IsMarker (lumpinfo_t* lump, char* marker)
+{
+	return !strncmp (lump->name, marker, 8);
+}
+
+
+//
+// W_HashLumps
+// Sets the namespace of every lump, and rebuilds the hash chains.
+// Lumps are linked in order, so each chain starts with the latest
+//  lump of that name, and patch lump files still take precedence.
+//
+static void W_HashLumps (void)
+{
+	lumpinfo_t*	lump_p;
+	lumpns_t	ns;
+	int		i;
+	int		hash;
+
+	ns = ns_global;
+
+	for (i=0, lump_p=lumpinfo ; i<numlumps ; i++, lump_p++) {
+		if (W_IsMarker (lump_p, "F_START") || W_IsMarker (lump_p, "FF_START")) {
+			ns = ns_flats;
+			lump_p->ns = ns_global;
+		} else if (W_IsMarker (lump_p, "S_START") || W_IsMarker (lump_p, "SS_START")) {
+			ns = ns_sprites;
+			lump_p->ns = ns_global;
+		} else if (W_IsMarker (lump_p, "F_END") || W_IsMarker (lump_p, "FF_END")
+			|| W_IsMarker (lump_p, "S_END") || W_IsMarker (lump_p, "SS_END"))
+		{
+			ns = ns_global;
+			lump_p->ns = ns_global;
+		} else
+			lump_p->ns = ns;
+	}
+
+	if (lumphash)
+		Z_Free (lumphash);
+
+	for (lumphashsize = 256 ; lumphashsize < numlumps ; lumphashsize <<= 1)
+		;
+	lumphash = Z_Malloc (lumphashsize*sizeof(int), PU_STATIC, NULL);
+
+	for (i=0 ; i<lumphashsize ; i++)
+		lumphash[i] = -1;
+
+	for (i=0, lump_p=lumpinfo ; i<numlumps ; i++, lump_p++) {
+		hash = W_HashName (*(int *)lump_p->name, *(int *)&lump_p->name[4]);
+		lump_p->next = lumphash[hash];
+		lumphash[hash] = i;
+	}
+}
+
+
+//
+// W_MapFile
+// With -mmap, maps the whole file read only. The lumps are then
+//  used right from the mapping, instead of being read in the zone.
+// Returns NULL if the file can not be mapped.
+//
+static byte* W_MapFile (int handle, int* length)
+{
+#ifdef HAVE_MMAP
+	struct stat	fileinfo;
+	void*		base;
+
+	if (!sysgame.mmap_wads)
+		return NULL;
+
+	if (nummapped == MAXMAPPEDFILES)
+		return NULL;
+
+	if (fstat (handle, &fileinfo) == -1 || fileinfo.st_size == 0)
+		return NULL;
+
+	base = mmap (NULL, fileinfo.st_size, PROT_READ, MAP_SHARED, handle, 0);
+	if (base == MAP_FAILED) {
+		printf (" couldn't map file, reading lumps instead\n");
+		return NULL;
+	}
+
+	mapbases[nummapped] = (byte *) base;
+	maplengths[nummapped] = fileinfo.st_size;
+	nummapped++;
+
+	*length = fileinfo.st_size;
+	return (byte *) base;
+#else
+	return NULL;
+#endif
+}
+
+
 //
 // W_AddFile
 // All files are optional, but at least one file must be
@@ -139,6 +289,9 @@ void W_AddFile (char *filename)
 	int			storehandle;
 	int newsize;
 	boolean islump;
+	byte*			mapbase;
+	int			maplength;
+	struct stat		filestat;
 
 	// open the file and add to directory
 
@@ -157,6 +310,13 @@ void W_AddFile (char *filename)
 	printf (" adding %s\n",filename);
 	startlump = numlumps;
 
+	if (fstat (handle, &filestat) != -1) {
+		filestamp = W_HashBytes (filestamp, &filestat.st_size,
+			sizeof(filestat.st_size));
+		filestamp = W_HashBytes (filestamp, &filestat.st_mtime,
+			sizeof(filestat.st_mtime));
+	}
+
 	islump=false;
 	if (strcasecmp (filename+strlen(filename)-3 , "wad" ) ) {
 		// single lump file
@@ -204,12 +364,24 @@ void W_AddFile (char *filename)
 
 	storehandle = reloadname ? -1 : handle;
 
+	// reloadable lumps change on disk, keep reading them
+	mapbase = NULL;
+	if (!reloadname)
+		mapbase = W_MapFile (handle, &maplength);
+
 	f_info = fileinfo;
 	for (i=startlump ; i<numlumps ; i++,lump_p++, f_info++) {
 		lump_p->handle = storehandle;
 		lump_p->position = LONG(f_info->filepos);
 		lump_p->size = LONG(f_info->size);
 		strncpy (lump_p->name, f_info->name, 8);
+
+		lump_p->mapped = NULL;
+		if (mapbase && lump_p->position >= 0 && lump_p->size >= 0
+			&& lump_p->position <= maplength - lump_p->size)
+		{
+			lump_p->mapped = mapbase + lump_p->position;
+		}
 	}
 
 	if (reloadname)
@@ -217,6 +389,8 @@ void W_AddFile (char *filename)
 
 	if (!islump)
 		Z_Free(fileinfo);
+
+	W_HashLumps ();
 }
 
 
@@ -327,6 +501,30 @@ void W_InitFile (char* filename)
 
 
 
+//
+// W_Checksum
+// Identifies the loaded WAD set, from the lump directory
+//  and the size and date of each file.
+//
+unsigned W_Checksum (void)
+{
+	lumpinfo_t*	lump_p;
+	unsigned	sum;
+	int		i;
+
+	sum = W_HashBytes (filestamp, &numlumps, sizeof(numlumps));
+
+	for (i=0, lump_p=lumpinfo ; i<numlumps ; i++, lump_p++) {
+		sum = W_HashBytes (sum, lump_p->name, 8);
+		sum = W_HashBytes (sum, &lump_p->position, sizeof(lump_p->position));
+		sum = W_HashBytes (sum, &lump_p->size, sizeof(lump_p->size));
+	}
+
+	return sum;
+}
+
+
+
 //
 // W_NumLumps
 //
@@ -338,11 +536,11 @@ int W_NumLumps (void)
 
 
 //
-// W_CheckNumForName
-// Returns -1 if name not found.
+// W_FindLump
+// Returns -1 if name not found in the namespace,
+//  any namespace if ns is -1.
 //
-
-int W_CheckNumForName (char* name)
+static int W_FindLump (char* name, int ns)
 {
 	union {
 		char	s[9];
@@ -351,8 +549,12 @@ int W_CheckNumForName (char* name)
 
 	int		v1;
 	int		v2;
+	int		i;
 	lumpinfo_t*	lump_p;
 
+	if (!lumphash)
+		return -1;
+
 	// make the name into two integers for easy compares
 	strncpy (name8.s,name,8);
 
@@ -366,20 +568,57 @@ int W_CheckNumForName (char* name)
 	v2 = name8.x[1];
 
 
-	// scan backwards so patch lump files take precedence
-	lump_p = lumpinfo + numlumps;
+	lookups++;
 
-	while (lump_p-- != lumpinfo) {
-		if ( *(int *)lump_p->name == v1 && *(int *)&lump_p->name[4] == v2) {
-			return lump_p - lumpinfo;
+	// the chain is latest first, so patch lump files take precedence
+	for (i = lumphash[W_HashName (v1, v2)] ; i != -1 ; i = lump_p->next) {
+		lump_p = lumpinfo + i;
+		probes++;
+
+		if ( *(int *)lump_p->name == v1 && *(int *)&lump_p->name[4] == v2
+			&& (ns == -1 || lump_p->ns == ns))
+		{
+			linearprobes += numlumps - i;
+			return i;
 		}
 	}
 
 	// TFB. Not found.
+	linearprobes += numlumps;
 	return -1;
 }
 
 
+//
+// W_CheckNumForName
+// Returns -1 if name not found.
+//
+int W_CheckNumForName (char* name)
+{
+	return W_FindLump (name, -1);
+}
+
+
+//
+// W_CheckNumForNameNs
+// Same, only looking at the lumps of a namespace.
+//
+int W_CheckNumForNameNs (char* name, lumpns_t ns)
+{
+	return W_FindLump (name, ns);
+}
+
+
+//
+// W_PrintLookupStats
+//
+void W_PrintLookupStats (void)
+{
+	printf ("W_PrintLookupStats: %i lookups, %i lumps compared"
+		" (%i for a linear scan)\n", lookups, probes, linearprobes);
+}
+
+
 
 
 //
@@ -433,6 +672,11 @@ W_ReadLump
 
 	l = lumpinfo+lump;
 
+	if (l->mapped) {
+		memcpy (dest, l->mapped, l->size);
+		return;
+	}
+
 	if (l->handle == -1) {
 		// reloadable file, so use open / read / close
 		if ( (handle = open (reloadname,O_RDONLY | O_BINARY)) == -1)
@@ -453,8 +697,26 @@ W_ReadLump
 
 
 
+//
+// W_IsMapped
+// True for data in a file mapped with -mmap.
+//
+static boolean W_IsMapped (void* ptr)
+{
+	int	i;
+
+	for (i=0 ; i<nummapped ; i++) {
+		if ((byte *)ptr >= mapbases[i]
+			&& (byte *)ptr < mapbases[i] + maplengths[i])
+			return true;
+	}
+	return false;
+}
+
+
 //
 // W_CacheLumpNum
+// Mapped lumps are returned as is, and must not be changed.
 //
 void*
 W_CacheLumpNum
@@ -466,6 +728,9 @@ W_CacheLumpNum
 	if ((unsigned)lump >= numlumps)
 		I_Error ("W_CacheLumpNum: %i >= numlumps",lump);
 
+	if (lumpinfo[lump].mapped)
+		return lumpinfo[lump].mapped;
+
 	if (!lumpcache[lump]) {
 		// read the lump in
 
@@ -482,6 +747,27 @@ W_CacheLumpNum
 
 
 
+//
+// W_LoadLumpNum
+// Reads the lump in a zone block of its own, mapped or not,
+//  for callers that change it.
+//
+void*
+W_LoadLumpNum
+( int		lump,
+  int		tag )
+{
+	void*	ptr;
+
+	if ((unsigned)lump >= numlumps)
+		I_Error ("W_LoadLumpNum: %i >= numlumps",lump);
+
+	ptr = Z_Malloc (W_LumpLength (lump), tag, NULL);
+	W_ReadLump (lump, ptr);
+	return ptr;
+}
+
+
 //
 // W_CacheLumpName
 //
@@ -494,6 +780,45 @@ W_CacheLumpName
 }
 
 
+//
+// W_ReleaseLumpNum
+// Makes a lump from W_CacheLumpNum purgable again.
+// Mapped lumps are not in the zone, there is nothing to do.
+//
+void W_ReleaseLumpNum (int lump)
+{
+	if ((unsigned)lump >= numlumps)
+		I_Error ("W_ReleaseLumpNum: %i >= numlumps",lump);
+
+	if (lumpinfo[lump].mapped)
+		return;
+
+	Z_ChangeTag (lumpcache[lump],PU_CACHE);
+}
+
+
+//
+// W_ReleaseLumpName
+//
+void W_ReleaseLumpName (char* name)
+{
+	W_ReleaseLumpNum (W_GetNumForName(name));
+}
+
+
+//
+// W_ReleaseLump
+// Same as W_ReleaseLumpNum, for callers that only kept the data.
+//
+void W_ReleaseLump (void* ptr)
+{
+	if (W_IsMapped (ptr))
+		return;
+
+	Z_ChangeTag (ptr,PU_CACHE);
+}
+
+
 //
 // W_Profile
 //
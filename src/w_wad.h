@@ -20,6 +20,8 @@
 #ifndef __W_WAD__
 #define __W_WAD__
 
+#include "doomtype.h"
+
 //
 // TYPES
 //
@@ -44,12 +46,28 @@ typedef struct
 //
 // WADFILE I/O related stuff.
 //
+//
+// Lumps between F_START/F_END (or FF_START/FF_END) are flats,
+//  lumps between S_START/S_END (or SS_START/SS_END) are sprites.
+//
+typedef enum
+{
+    ns_global,
+    ns_flats,
+    ns_sprites
+} lumpns_t;
+
 typedef struct
 {
     char	name[8];
     int		handle;
     int		position;
     int		size;
+
+    lumpns_t	ns;
+    int		next;	// next lump in the same hash chain, or -1
+
+    byte*	mapped;	// lump data in the mapped file, or NULL
 } lumpinfo_t;
 
 
@@ -60,13 +78,25 @@ extern	int		numlumps;
 void    W_InitMultipleFiles (char** filenames);
 void    W_Reload (void);
 
+unsigned W_Checksum (void);
+
 int	W_CheckNumForName (char* name);
+int	W_CheckNumForNameNs (char* name, lumpns_t ns);
 int	W_GetNumForName (char* name);
 
+void	W_PrintLookupStats (void);
+
 int	W_LumpLength (int lump);
 void    W_ReadLump (int lump, void *dest);
 
 void*	W_CacheLumpNum (int lump, int tag);
+void*	W_LoadLumpNum (int lump, int tag);
 void*	W_CacheLumpName (char* name, int tag);
 
+// Cached lumps are given back with these, not with Z_ChangeTag
+//  or Z_Free, as mapped lumps are not in the zone.
+void	W_ReleaseLumpNum (int lump);
+void	W_ReleaseLumpName (char* name);
+void	W_ReleaseLump (void* ptr);
+
 #endif
@@ -1713,25 +1713,25 @@ void WI_unloadData(void)
     int		j;
 
 	if (wiminus)
-	    Z_ChangeTag(wiminus, PU_CACHE);
+	    W_ReleaseLump(wiminus);
 
     for (i=0 ; i<10 ; i++)
-	Z_ChangeTag(num[i], PU_CACHE);
+	W_ReleaseLump(num[i]);
     
     if (gamemode == commercial)
     {
   	for (i=0 ; i<NUMCMAPS ; i++)
-	    Z_ChangeTag(lnames[i], PU_CACHE);
+	    W_ReleaseLump(lnames[i]);
     }
     else
     {
-	Z_ChangeTag(yah[0], PU_CACHE);
-	Z_ChangeTag(yah[1], PU_CACHE);
+	W_ReleaseLump(yah[0]);
+	W_ReleaseLump(yah[1]);
 
-	Z_ChangeTag(splat, PU_CACHE);
+	W_ReleaseLump(splat);
 
 	for (i=0 ; i<NUMMAPS ; i++)
-	    Z_ChangeTag(lnames[i], PU_CACHE);
+	    W_ReleaseLump(lnames[i]);
 	
 	if (wbs->epsd < 3)
 	{
@@ -1739,37 +1739,37 @@ void WI_unloadData(void)
 	    {
 		if (wbs->epsd != 1 || j != 8)
 		    for (i=0;i<anims[wbs->epsd][j].nanims;i++)
-			Z_ChangeTag(anims[wbs->epsd][j].p[i], PU_CACHE);
+			W_ReleaseLump(anims[wbs->epsd][j].p[i]);
 	    }
 	}
     }
     
     Z_Free(lnames);
 
-    Z_ChangeTag(percent, PU_CACHE);
-    Z_ChangeTag(colon, PU_CACHE);
-    Z_ChangeTag(finished, PU_CACHE);
-    Z_ChangeTag(entering, PU_CACHE);
-    Z_ChangeTag(kills, PU_CACHE);
-    Z_ChangeTag(secret, PU_CACHE);
-    Z_ChangeTag(sp_secret, PU_CACHE);
-    Z_ChangeTag(items, PU_CACHE);
-    Z_ChangeTag(frags, PU_CACHE);
-    Z_ChangeTag(time, PU_CACHE);
-    Z_ChangeTag(sucks, PU_CACHE);
-    Z_ChangeTag(par, PU_CACHE);
-
-    Z_ChangeTag(victims, PU_CACHE);
-    Z_ChangeTag(killers, PU_CACHE);
-    Z_ChangeTag(total, PU_CACHE);
-    //  Z_ChangeTag(star, PU_CACHE);
-    //  Z_ChangeTag(bstar, PU_CACHE);
+    W_ReleaseLump(percent);
+    W_ReleaseLump(colon);
+    W_ReleaseLump(finished);
+    W_ReleaseLump(entering);
+    W_ReleaseLump(kills);
+    W_ReleaseLump(secret);
+    W_ReleaseLump(sp_secret);
+    W_ReleaseLump(items);
+    W_ReleaseLump(frags);
+    W_ReleaseLump(time);
+    W_ReleaseLump(sucks);
+    W_ReleaseLump(par);
+
+    W_ReleaseLump(victims);
+    W_ReleaseLump(killers);
+    W_ReleaseLump(total);
+    //  W_ReleaseLump(star);
+    //  W_ReleaseLump(bstar);
     
     for (i=0 ; i<MAXPLAYERS ; i++)
-	Z_ChangeTag(p[i], PU_CACHE);
+	W_ReleaseLump(p[i]);
 
     for (i=0 ; i<MAXPLAYERS ; i++)
-	Z_ChangeTag(bp[i], PU_CACHE);
+	W_ReleaseLump(bp[i]);
 }
 
 void WI_Drawer (void)
@@ -17,7 +17,12 @@
 //
 //-----------------------------------------------------------------------------
 
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
 #include <stdio.h>
+#include <stddef.h>
 
 #include "z_zone.h"
 #include "i_system.h"
@@ -36,6 +41,7 @@
 // 
  
 #define ZONEID	0x1d4a11
+#define POOLID	0x1d4a12
 
 
 typedef struct
@@ -55,6 +61,140 @@ typedef struct
 memzone_t*	mainzone;
 
 
+#ifdef ENABLE_ZONE_SIZECLASS
+//
+// SIZE CLASS ALLOCATION
+//
+// Free blocks are also kept in one list per power of two size,
+//  so Z_Malloc does not have to walk the heap.
+// Purgable blocks are kept in a list, most recently tagged first,
+//  and the oldest ones are purged only when no free block is big
+//  enough.
+// Purgable blocks are cut from the end of free blocks, other ones
+//  from the start, so cached lumps gather at the top of the zone
+//  and level data at the bottom.
+// The block list is the same as for the rover allocation, and
+//  still used to merge free neighbours.
+//
+
+#define NUMBINS		32
+
+typedef struct zblock_s
+{
+    // size class list if free, purge list if purgable
+    struct zblock_s*	lnext;
+    struct zblock_s*	lprev;
+
+    // last, so it is right before the data
+    memblock_t		mb;
+
+} zblock_t;
+
+#define ZBLOCK(b)	((zblock_t *)((byte *)(b) - offsetof(zblock_t, mb)))
+
+static zblock_t*	bins[NUMBINS];
+static unsigned		binmask;	// bit set for each used bin
+static zblock_t		purgelist;
+
+
+static int Z_Bin (int size)
+{
+    int		bin;
+
+    for (bin = 0 ; size > 1 && bin < NUMBINS-1 ; bin++)
+	size >>= 1;
+
+    return bin;
+}
+
+
+static void Z_LinkFree (zblock_t* z)
+{
+    int		bin;
+
+    bin = Z_Bin (z->mb.size);
+
+    z->lprev = NULL;
+    z->lnext = bins[bin];
+    if (z->lnext)
+	z->lnext->lprev = z;
+    bins[bin] = z;
+
+    binmask |= 1u<<bin;
+}
+
+
+static void Z_UnlinkFree (zblock_t* z)
+{
+    int		bin;
+
+    bin = Z_Bin (z->mb.size);
+
+    if (z->lprev)
+	z->lprev->lnext = z->lnext;
+    else
+	bins[bin] = z->lnext;
+    if (z->lnext)
+	z->lnext->lprev = z->lprev;
+
+    if (!bins[bin])
+	binmask &= ~(1u<<bin);
+}
+
+
+static void Z_LinkPurge (zblock_t* z)
+{
+    z->lprev = &purgelist;
+    z->lnext = purgelist.lnext;
+    z->lnext->lprev = z;
+    purgelist.lnext = z;
+}
+
+
+static void Z_UnlinkPurge (zblock_t* z)
+{
+    z->lprev->lnext = z->lnext;
+    z->lnext->lprev = z->lprev;
+}
+#endif
+
+
+
+//
+// POOLS
+//
+#define POOLSLAB	32
+
+static zpool_t*	pools;
+
+
+static void Z_PoolAppend (zpool_t* pool, memblock_t* block)
+{
+    block->next = NULL;
+
+    if (pool->freetail)
+	pool->freetail->next = block;
+    else
+	pool->freehead = block;
+    pool->freetail = block;
+}
+
+
+//
+// Z_PoolFree
+// Called by Z_Free for blocks with POOLID.
+//
+static void Z_PoolFree (memblock_t* block)
+{
+    zpool_t*	pool;
+
+    pool = (zpool_t *) block->user;
+
+    block->id = 0;
+    Z_PoolAppend (pool, block);
+    pool->live--;
+}
+
 
 //
 // Z_ClearZone
@@ -94,9 +234,13 @@ void Z_Init (void)
     mainzone->size = size;
 
     // set the entire zone to one free block
+#ifdef ENABLE_ZONE_SIZECLASS
+    block = &((zblock_t *)( (byte *)mainzone + sizeof(memzone_t) ))->mb;
+#else
+    block = (memblock_t *)( (byte *)mainzone + sizeof(memzone_t) );
+#endif
     mainzone->blocklist.next =
-	mainzone->blocklist.prev =
-	block = (memblock_t *)( (byte *)mainzone + sizeof(memzone_t) );
+	mainzone->blocklist.prev = block;
 
     mainzone->blocklist.user = (void *)mainzone;
     mainzone->blocklist.tag = PU_STATIC;
@@ -108,8 +252,223 @@ void Z_Init (void)
     block->user = NULL;
     
     block->size = mainzone->size - sizeof(memzone_t);
+
+#ifdef ENABLE_ZONE_SIZECLASS
+    purgelist.lnext = purgelist.lprev = &purgelist;
+    Z_LinkFree (ZBLOCK(block));
+#endif
+}
+
+
+#ifdef ENABLE_ZONE_SIZECLASS
+//
+// Z_FreeBlock
+// Returns the free block, after merging with its neighbours.
+//
+static zblock_t* Z_FreeBlock (memblock_t* block)
+{
+    memblock_t*		other;
+
+    if (block->user > (void **)0x100)
+    {
+	// clear the user's mark
+	*block->user = 0;
+    }
+
+    if (block->tag >= PU_PURGELEVEL)
+	Z_UnlinkPurge (ZBLOCK(block));
+
+    // mark as free
+    block->user = NULL;
+    block->tag = 0;
+    block->id = 0;
+
+    other = block->prev;
+    if (!other->user)
+    {
+	// merge with previous free block
+	Z_UnlinkFree (ZBLOCK(other));
+	other->size += block->size;
+	other->next = block->next;
+	other->next->prev = other;
+
+	block = other;
+    }
+
+    other = block->next;
+    if (!other->user)
+    {
+	// merge the next free block onto the end
+	Z_UnlinkFree (ZBLOCK(other));
+	block->size += other->size;
+	block->next = other->next;
+	block->next->prev = block;
+    }
+
+    Z_LinkFree (ZBLOCK(block));
+    return ZBLOCK(block);
+}
+
+
+//
+// Z_Free
+//
+void Z_Free (void* ptr)
+{
+    memblock_t*		block;
+
+    block = (memblock_t *) ( (byte *)ptr - sizeof(memblock_t));
+
+    if (block->id == POOLID)
+    {
+	Z_PoolFree (block);
+	return;
+    }
+
+    if (block->id != ZONEID)
+	I_Error ("Z_Free: freed a pointer without ZONEID");
+
+    Z_FreeBlock (block);
+}
+
+
+
+//
+// Z_FindFree
+// First fit in the size class of the block,
+//  else any block of a bigger class.
+//
+static zblock_t* Z_FindFree (int size)
+{
+    zblock_t*	z;
+    unsigned	mask;
+    int		bin;
+
+    bin = Z_Bin (size);
+
+    for (z = bins[bin] ; z ; z = z->lnext)
+	if (z->mb.size >= size)
+	    return z;
+
+    mask = binmask & ~((2u<<bin) - 1);
+    if (!mask)
+	return NULL;
+
+    while (!(mask & (1u<<bin)))
+	bin++;
+
+    return bins[bin];
+}
+
+
+
+//
+// Z_Malloc
+// You can pass a NULL user if the tag is < PU_PURGELEVEL.
+//
+#define MINFRAGMENT		64
+
+
+void*
+Z_Malloc
+( int		size,
+  int		tag,
+  void*		user )
+{
+    int		extra;
+    zblock_t*	z;
+    memblock_t*	base;
+    memblock_t*	newblock;
+
+    // keep the data aligned for pointers
+    size = (size + 7) & ~7;
+
+    // account for size of block header
+    size += sizeof(zblock_t);
+
+    // purge the oldest cached blocks until one is freed next to
+    //  enough free space
+    z = Z_FindFree (size);
+
+    while (!z)
+    {
+	if (purgelist.lprev == &purgelist)
+	    I_Error ("Z_Malloc: failed on allocation of %i bytes", size);
+
+	z = Z_FreeBlock (&purgelist.lprev->mb);
+	if (z->mb.size < size)
+	    z = NULL;
+    }
+
+    Z_UnlinkFree (z);
+    base = &z->mb;
+
+    // found a block big enough
+    extra = base->size - size;
+
+    if (extra >  MINFRAGMENT)
+    {
+	if (tag >= PU_PURGELEVEL)
+	{
+	    // allocate from the end, the start stays free
+	    newblock = (memblock_t *) ((byte *)base + extra);
+	    newblock->size = size;
+	    newblock->prev = base;
+	    newblock->next = base->next;
+	    newblock->next->prev = newblock;
+
+	    base->next = newblock;
+	    base->size = extra;
+	    Z_LinkFree (z);
+
+	    base = newblock;
+	    z = ZBLOCK(base);
+	}
+	else
+	{
+	    // there will be a free fragment after the allocated block
+	    newblock = (memblock_t *) ((byte *)base + size );
+	    newblock->size = extra;
+
+	    // NULL indicates free block.
+	    newblock->user = NULL;
+	    newblock->tag = 0;
+	    newblock->id = 0;
+	    newblock->prev = base;
+	    newblock->next = base->next;
+	    newblock->next->prev = newblock;
+
+	    base->next = newblock;
+	    base->size = size;
+	    Z_LinkFree (ZBLOCK(newblock));
+	}
+    }
+
+    if (user)
+    {
+	// mark as an in use block
+	base->user = user;
+	*(void **)user = (void *) ((byte *)base + sizeof(memblock_t));
+    }
+    else
+    {
+	if (tag >= PU_PURGELEVEL)
+	    I_Error ("Z_Malloc: an owner is required for purgable blocks");
+
+	// mark as in use, but unowned
+	base->user = (void *)2;
+    }
+    base->tag = tag;
+
+    if (tag >= PU_PURGELEVEL)
+	Z_LinkPurge (z);
+
+    base->id = ZONEID;
+
+    return (void *) ((byte *)base + sizeof(memblock_t));
 }
 
+#else
 
 //
 // Z_Free
@@ -121,6 +480,12 @@ void Z_Free (void* ptr)
 	
     block = (memblock_t *) ( (byte *)ptr - sizeof(memblock_t));
 
+    if (block->id == POOLID)
+    {
+	Z_PoolFree (block);
+	return;
+    }
+
     if (block->id != ZONEID)
 	I_Error ("Z_Free: freed a pointer without ZONEID");
 		
@@ -188,6 +553,7 @@ Z_Malloc
     memblock_t*	base;
 
     size = (size + 3) & ~3;
+
     
     // scan through the block list,
     // looking for the first free block
@@ -283,6 +649,8 @@ Z_Malloc
     return (void *) ((byte *)base + sizeof(memblock_t));
 }
 
+#endif
+
 
 
 //
@@ -295,6 +663,7 @@ Z_FreeTags
 {
     memblock_t*	block;
     memblock_t*	next;
+    zpool_t*	pool;
 	
     for (block = mainzone->blocklist.next ;
 	 block != &mainzone->blocklist ;
@@ -310,6 +679,101 @@ Z_FreeTags
 	if (block->tag >= lowtag && block->tag <= hightag)
 	    Z_Free ( (byte *)block+sizeof(memblock_t));
     }
+
+    // their slabs are gone
+    for (pool = pools ; pool ; pool = pool->next)
+    {
+	if (pool->tag >= lowtag && pool->tag <= hightag)
+	{
+	    pool->freehead = pool->freetail = NULL;
+	    pool->live = pool->peak = pool->slabs = 0;
+	}
+    }
+}
+
+
+
+//
+// Z_InitPool
+//
+void
+Z_InitPool
+( zpool_t*	pool,
+  char*		name,
+  int		size,
+  int		tag )
+{
+    if (tag >= PU_PURGELEVEL)
+	I_Error ("Z_InitPool: pools can not be purgable");
+
+    pool->name = name;
+    pool->size = sizeof(memblock_t) + ((size + 7) & ~7);
+    pool->tag = tag;
+
+    pool->freehead = pool->freetail = NULL;
+    pool->live = pool->peak = pool->slabs = 0;
+
+    pool->next = pools;
+    pools = pool;
+}
+
+
+
+//
+// Z_PoolMalloc
+// Reuses the block freed the longest ago, like the rover would:
+//  play code still reads thinkers right after removing them.
+//
+void* Z_PoolMalloc (zpool_t* pool)
+{
+    memblock_t*	block;
+    byte*	slab;
+    int		i;
+
+    if (!pool->freehead)
+    {
+	slab = Z_Malloc (POOLSLAB*pool->size, pool->tag, NULL);
+
+	for (i=0 ; i<POOLSLAB ; i++)
+	{
+	    block = (memblock_t *) (slab + i*pool->size);
+	    block->size = pool->size;
+	    block->user = (void **) pool;
+	    block->tag = pool->tag;
+	    block->id = 0;
+	    Z_PoolAppend (pool, block);
+	}
+	pool->slabs++;
+    }
+
+    block = pool->freehead;
+    pool->freehead = block->next;
+    if (!pool->freehead)
+	pool->freetail = NULL;
+
+    block->id = POOLID;
+
+    if (++pool->live > pool->peak)
+	pool->peak = pool->live;
+
+    return (void *) ((byte *)block + sizeof(memblock_t));
+}
+
+
+
+//
+// Z_PoolStats
+//
+void Z_PoolStats (void)
+{
+    zpool_t*	pool;
+
+    for (pool = pools ; pool ; pool = pool->next)
+    {
+	if (pool->peak)
+	    printf ("Z_PoolStats: %-8s %5i live, %5i peak, %3i slabs\n",
+		    pool->name, pool->live, pool->peak, pool->slabs);
+    }
 }
 
 
@@ -436,6 +900,14 @@ Z_ChangeTag2
     if (tag >= PU_PURGELEVEL && (unsigned)block->user < 0x100)
 	I_Error ("Z_ChangeTag: an owner is required for purgable blocks");
 
+#ifdef ENABLE_ZONE_SIZECLASS
+    // retagging as purgable makes it the most recent one
+    if (block->tag >= PU_PURGELEVEL)
+	Z_UnlinkPurge (ZBLOCK(block));
+    if (tag >= PU_PURGELEVEL)
+	Z_LinkPurge (ZBLOCK(block));
+#endif
+
     block->tag = tag;
 }
 
@@ -23,6 +23,8 @@
 #ifndef __Z_ZONE__
 #define __Z_ZONE__
 
+#include <stdio.h>
+
 //
 // ZONE MEMORY
 // PU - purge tags.
@@ -59,6 +61,34 @@ typedef struct memblock_s
     struct memblock_s*	prev;
 } memblock_t;
 
+
+//
+// Pools of blocks of one size, for the thinkers.
+// Blocks are cut from slabs allocated in the zone with the
+//  pool tag, so Z_FreeTags empties the pool with the slabs.
+// Z_Free gives a block back to its pool.
+//
+typedef struct zpool_s
+{
+    char*		name;
+    int			size;	// including the header
+    int			tag;
+
+    // free blocks, oldest first
+    memblock_t*		freehead;
+    memblock_t*		freetail;
+
+    int			live;
+    int			peak;	// since the pool was last emptied
+    int			slabs;
+
+    struct zpool_s*	next;
+} zpool_t;
+
+void	Z_InitPool (zpool_t* pool, char* name, int size, int tag);
+void*	Z_PoolMalloc (zpool_t* pool);
+void	Z_PoolStats (void);
+
 //
 // This is used to get the local FILE:LINE info from CPP
 // prior to really call the function in question.